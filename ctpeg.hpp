@@ -1,12 +1,21 @@
 #ifndef CTPEG_HPP
 #define CTPEG_HPP
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cassert>
 #include <concepts>
 #include <cstdint>
+#include <limits>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <tl/expected.hpp>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 //#include <variant>
 
 /*
@@ -180,13 +189,29 @@ template <std::integral Base, std::integral Exp>
 namespace ctpeg {
 inline namespace v0_3_1 {
 struct UninitialisedVariant {};
+constexpr bool operator==(const UninitialisedVariant &,
+                          const UninitialisedVariant &) {
+    return true;
+}
 struct EmptyVariant {};
 constexpr bool operator==(const EmptyVariant &, const EmptyVariant &) {
     return true;
 }
 
+using Error_t = std::string_view;
+
+// Produced by Recover in place of the value of a parser which failed.
+// `skipped` is the part of the input which was skipped to recover.
+struct RecoveredError {
+    Error_t error;
+    std::string_view skipped;
+
+    constexpr bool operator==(const RecoveredError &) const = default;
+};
+
 using ResultVariantSingle = std::variant<UninitialisedVariant, EmptyVariant,
-                                         char, std::string_view, int64_t
+                                         char, std::string_view, int64_t,
+                                         RecoveredError
 #ifdef CTPEG_VARIANT
                                          ,
                                          CTPEG_VARIANT
@@ -197,7 +222,6 @@ using ResultVariantSingle = std::variant<UninitialisedVariant, EmptyVariant,
 #define CTPEG_MAX_SEQUENCE_LENGTH 100
 #endif
 
-using Error_t = std::string_view;
 template <typename T>
 using ErrorOr = tl::expected<T, Error_t>;
 
@@ -208,11 +232,40 @@ using ResultVariant =
 
 using Result = ErrorOr<std::pair<ResultVariant, std::string_view>>;
 
+// Input left over after a successful match, used where no value is built
+using Remaining = ErrorOr<std::string_view>;
+
+// Error of a parse which went deeper than its DepthLimit allows
+inline constexpr Error_t TooDeep{"Input is nested too deeply"};
+
 template <typename P>
 concept Parser = requires(P p, std::string_view sv) {
                      { p(sv) } -> std::same_as<Result>;
                  };
 
+// Type of the slot a parser writes its value into when called through
+// `parse(sv, slot)`, which only returns the remaining input. Parsers which only
+// return a Result (e.g. plain functions) fill a whole ResultVariant.
+template <typename P>
+struct ValueOf {
+    using type = ResultVariant;
+};
+
+template <typename P>
+    requires requires { typename P::value_type; }
+struct ValueOf<P> {
+    using type = typename P::value_type;
+};
+
+template <typename P>
+using ValueOf_t = typename ValueOf<P>::type;
+
+template <Parser... Args>
+struct ChoiceParser;
+
+template <Parser... Args>
+struct SequenceParser;
+
 }  // namespace v0_3_1
 }  // namespace ctpeg
 
@@ -225,36 +278,300 @@ concept Parser = requires(P p, std::string_view sv) {
 namespace ctpeg::detail {
 inline namespace v0_3_1 {
 
-[[nodiscard]] CTPEG_CONSTEXPR
-    ErrorOr<std::array<std::pair<ResultVariant, std::string_view>, 1>>
-    SequenceImpl(std::string_view sv, Parser auto arg) noexcept {
-    if (auto ret = arg(sv)) {
-        return std::array{ret.value()};
-    }
-    return tl::unexpected<Error_t>(Error_t{"Failed to parse Sequence"});
-}
-
-template <Parser Arg, Parser... Args>
-[[nodiscard]] CTPEG_CONSTEXPR ErrorOr<
-    std::array<std::pair<ResultVariant, std::string_view>, sizeof...(Args) + 1>>
-SequenceImpl(std::string_view sv, Arg arg, Args... rest) noexcept {
-    if (auto ret = arg(sv)) {
-        auto r = SequenceImpl(ret.value().second, rest...);
-        if (r) {
-            std::array<std::pair<ResultVariant, std::string_view>,
-                       sizeof...(Args) + 1>
-                tmp{ret.value()};
-            std::copy(r.value().begin(), r.value().end(),
-                      std::next(tmp.begin()));
-            return tmp;
-        } else {
-            return tl::unexpected<Error_t>(r.error());
+// Lets contexts which want to know about it (e.g. MemoTable) see how far into
+// the input a parser which does not take contexts could have looked.
+template <typename P, typename... Ctx>
+CTPEG_CONSTEXPR void observe(const P &p, std::string_view sv,
+                             const Remaining &ret, Ctx &...ctx) noexcept {
+    (
+        [&](auto &c) {
+            if constexpr (requires { c.observe(p, sv, ret); }) {
+                c.observe(p, sv, ret);
+            }
+        }(ctx),
+        ...);
+}
+
+// Calls the parser with the context of the current parse if it accepts one.
+// Plain functions and primitives are called without it.
+template <typename P, typename... Ctx>
+[[nodiscard]] CTPEG_CONSTEXPR Result call(const P &p, std::string_view sv,
+                                          Ctx &...ctx) {
+    if constexpr (requires { p(sv, ctx...); }) {
+        return p(sv, ctx...);
+    } else {
+        auto ret = p(sv);
+        if constexpr (sizeof...(Ctx) != 0) {
+            observe(p, sv,
+                    ret ? Remaining{ret.value().second}
+                        : Remaining{tl::unexpected<Error_t>(ret.error())},
+                    ctx...);
         }
+        return ret;
+    }
+}
+
+// Matches the parser without building a value. Parsers which do not provide a
+// value-free `recognize` (e.g. user functions) are run in full and their value
+// is discarded. The only context which is passed down is the DepthLimit.
+template <typename P>
+[[nodiscard]] CTPEG_CONSTEXPR Remaining recognize(const P &p,
+                                                  std::string_view sv,
+                                                  auto &...ctx) noexcept {
+    if constexpr (requires { p.recognize(sv, ctx...); }) {
+        return p.recognize(sv, ctx...);
+    } else if constexpr (requires { p.recognize(sv); }) {
+        return p.recognize(sv);
+    } else if (auto ret = p(sv)) {
+        return ret.value().second;
     } else {
         return tl::unexpected<Error_t>(ret.error());
     }
 }
 
+// Records the state of every context, so that it can be rolled back if the
+// parser which is about to run fails
+template <typename... Ctx>
+[[nodiscard]] CTPEG_CONSTEXPR std::array<std::size_t, sizeof...(Ctx)> mark(
+    Ctx &...ctx) noexcept {
+    return {ctx.mark()...};
+}
+
+// Discards everything recorded in the contexts since `m` was taken
+template <typename... Ctx>
+CTPEG_CONSTEXPR void rollback(
+    [[maybe_unused]] const std::array<std::size_t, sizeof...(Ctx)> &m,
+    Ctx &...ctx) noexcept {
+    std::size_t i = 0;
+    (ctx.rollback(m[i++]), ...);
+}
+
+// Tells the contexts that the parser which ran since `m` was taken has matched,
+// so what it recorded will not be rolled back any more. Contexts which never
+// need to know (i.e. all which don't have a `commit`) are skipped.
+template <typename... Ctx>
+CTPEG_CONSTEXPR void commit(
+    [[maybe_unused]] const std::array<std::size_t, sizeof...(Ctx)> &m,
+    Ctx &...ctx) {
+    std::size_t i = 0;
+    (
+        [&](auto &c) {
+            if constexpr (requires { c.commit(m[i]); }) {
+                c.commit(m[i]);
+            }
+            i++;
+        }(ctx),
+        ...);
+}
+
+// Whether a context of type T was passed to the parser
+template <typename T, typename... Ctx>
+constexpr bool HasContext_v =
+    (std::same_as<T, std::remove_cvref_t<Ctx>> || ...);
+
+// The context of type T out of all the contexts passed to the parser
+template <typename T, typename C, typename... Ctx>
+[[nodiscard]] CTPEG_CONSTEXPR T &context(C &c, Ctx &...ctx) noexcept {
+    if constexpr (std::same_as<T, C>) {
+        return c;
+    } else {
+        return context<T>(ctx...);
+    }
+}
+
+// The parsers a Choice stores for `arg`. The alternatives of a nested Choice
+// are stored directly, so that Choice(Choice(a, b), c) is tried like
+// Choice(a, b, c).
+template <typename Arg>
+[[nodiscard]] CTPEG_CONSTEXPR std::tuple<Arg> flatChoice(
+    const Arg &arg) noexcept {
+    return std::tuple<Arg>{arg};
+}
+
+template <typename... Args>
+[[nodiscard]] CTPEG_CONSTEXPR std::tuple<Args...> flatChoice(
+    const ChoiceParser<Args...> &arg) noexcept {
+    return arg.m_args;
+}
+
+// Same as above for the elements of a Sequence
+template <typename Arg>
+[[nodiscard]] CTPEG_CONSTEXPR std::tuple<Arg> flatSequence(
+    const Arg &arg) noexcept {
+    return std::tuple<Arg>{arg};
+}
+
+template <typename... Args>
+[[nodiscard]] CTPEG_CONSTEXPR std::tuple<Args...> flatSequence(
+    const SequenceParser<Args...> &arg) noexcept {
+    return arg.m_args;
+}
+
+// Whether T is stored in a ResultVariantSingle rather than needing the whole
+// ResultVariant
+template <typename T>
+constexpr bool IsSingle_v = !std::same_as<T, ResultVariant> &&
+                            !std::same_as<T, ResultVariantArray>;
+
+// The smallest slot which can hold the value of any of the parsers of a Choice.
+// A Choice without any never matches, so there is no value to hold.
+template <typename... Ts>
+struct CommonValue {
+    using type = EmptyVariant;
+};
+
+template <typename T, typename... Ts>
+struct CommonValue<T, Ts...> {
+    using type = std::conditional_t<
+        (std::same_as<T, Ts> && ...), T,
+        std::conditional_t<IsSingle_v<T> && (IsSingle_v<Ts> && ...),
+                           ResultVariantSingle, ResultVariant>>;
+};
+
+template <typename... Ts>
+using CommonValue_t = typename CommonValue<Ts...>::type;
+
+[[nodiscard]] CTPEG_CONSTEXPR const ResultVariant &toResultVariant(
+    const ResultVariant &value) noexcept {
+    return value;
+}
+
+[[nodiscard]] CTPEG_CONSTEXPR ResultVariant
+toResultVariant(const ResultVariantSingle &value) noexcept {
+    return std::visit([](const auto &v) { return ResultVariant{v}; }, value);
+}
+
+template <typename T>
+[[nodiscard]] CTPEG_CONSTEXPR ResultVariant
+toResultVariant(const T &value) noexcept {
+    return ResultVariant{value};
+}
+
+// Stores a value in a slot of a wider type
+template <typename To, typename From>
+CTPEG_CONSTEXPR void assign(To &out, const From &value) noexcept {
+    if constexpr (std::same_as<To, From>) {
+        out = value;
+    } else if constexpr (std::same_as<To, ResultVariant>) {
+        out = toResultVariant(value);
+    } else {
+        out = To{value};
+    }
+}
+
+inline constexpr Error_t TooLong{"Result is too long"};
+
+// Errors which trying another alternative or stopping a repetition early would
+// not get rid of. They are passed on as they are instead of being backtracked
+// over, so that such a parse fails rather than matching something else.
+[[nodiscard]] CTPEG_CONSTEXPR bool isFatal(Error_t error) noexcept {
+    return error == TooLong || error == TooDeep;
+}
+
+// Stores `value` in `out` at `i`. The elements of a nested array are stored in
+// its place one after another. Returns false if `out` has run out of space.
+template <typename T>
+[[nodiscard]] CTPEG_CONSTEXPR bool append(ResultVariantArray &out,
+                                          std::size_t &i,
+                                          const T &value) noexcept {
+    if constexpr (std::same_as<T, ResultVariant>) {
+        return std::visit(
+            [&out, &i](const auto &v) { return append(out, i, v); }, value);
+    } else if constexpr (std::same_as<T, ResultVariantArray>) {
+        for (const auto &elem : value) {
+            if (std::holds_alternative<UninitialisedVariant>(elem)) break;
+            if (i == out.size()) return false;
+            out[i++] = elem;
+        }
+        return true;
+    } else {
+        if (i == out.size()) return false;
+        out[i++] = ResultVariantSingle{value};
+        return true;
+    }
+}
+
+// Removes the values appended to `out` since it held `first` of them
+CTPEG_CONSTEXPR void truncate(ResultVariantArray &out, std::size_t &n,
+                              std::size_t first) noexcept {
+    for (; n > first; n--) out[n - 1] = UninitialisedVariant{};
+}
+
+// Runs the parser, writing its value into `out`. Parsers which only provide
+// the Result returning call operator (e.g. plain functions) are run through it.
+// Array slots have to be empty.
+template <typename P, typename... Ctx>
+[[nodiscard]] CTPEG_CONSTEXPR Remaining parse(const P &p, std::string_view sv,
+                                              ValueOf_t<P> &out, Ctx &...ctx) {
+    if constexpr (requires { p.parse(sv, out, ctx...); }) {
+        return p.parse(sv, out, ctx...);
+    } else if constexpr (requires { p.parse(sv, out); }) {
+        auto ret = p.parse(sv, out);
+        observe(p, sv, ret, ctx...);
+        return ret;
+    } else {
+        auto ret = call(p, sv, ctx...);
+        if (!ret) return tl::unexpected<Error_t>(ret.error());
+        out = ret.value().first;
+        return ret.value().second;
+    }
+}
+
+// Same as above, but the slot may be wider than the value of the parser. On
+// failure the slot may have been changed.
+template <typename T, typename P, typename... Ctx>
+[[nodiscard]] CTPEG_CONSTEXPR Remaining parseAs(const P &p, std::string_view sv,
+                                                T &out, Ctx &...ctx) {
+    if constexpr (std::same_as<T, ValueOf_t<P>>) {
+        return parse(p, sv, out, ctx...);
+    } else if constexpr (std::same_as<T, ResultVariant> &&
+                         std::same_as<ValueOf_t<P>, ResultVariantArray>) {
+        // Arrays are built in place, rather than in a temporary which would
+        // take another CTPEG_MAX_SEQUENCE_LENGTH values worth of stack for
+        // every level of nesting
+        return parse(p, sv, out.template emplace<ResultVariantArray>(),
+                     ctx...);
+    } else {
+        ValueOf_t<P> value{};
+        auto ret = parse(p, sv, value, ctx...);
+        if (ret) assign(out, value);
+        return ret;
+    }
+}
+
+// Appends the value of the parser to the `n` values already in `out`. On
+// failure both `out` and `n` are left as they were.
+template <typename P, typename... Ctx>
+[[nodiscard]] CTPEG_CONSTEXPR Remaining extend(const P &p, std::string_view sv,
+                                               ResultVariantArray &out,
+                                               std::size_t &n, Ctx &...ctx) {
+    if constexpr (requires { p.extend(sv, out, n, ctx...); }) {
+        return p.extend(sv, out, n, ctx...);
+    } else {
+        ValueOf_t<P> value{};
+        auto ret = parse(p, sv, value, ctx...);
+        const auto first = n;
+        if (ret && !append(out, n, value)) {
+            CTPEG_TRACE debug::print(
+                "Failed on input \"", sv,
+                "\". Result does not fit CTPEG_MAX_SEQUENCE_LENGTH\n");
+            truncate(out, n, first);
+            return tl::unexpected<Error_t>(TooLong);
+        }
+        return ret;
+    }
+}
+
+// The Result returning call operator of the built-in parsers
+template <typename P, typename... Ctx>
+[[nodiscard]] CTPEG_CONSTEXPR Result adapt(const P &p, std::string_view sv,
+                                           Ctx &...ctx) {
+    ValueOf_t<P> out{};
+    auto ret = p.parse(sv, out, ctx...);
+    if (!ret) return tl::unexpected<Error_t>(ret.error());
+    return std::make_pair(ResultVariant{toResultVariant(out)}, ret.value());
+}
+
 }  // namespace v0_3_1
 }  // namespace ctpeg::detail
 
@@ -267,125 +584,504 @@ SequenceImpl(std::string_view sv, Arg arg, Args... rest) noexcept {
 namespace ctpeg {
 inline namespace v0_3_1 {
 
-[[nodiscard]] CTPEG_CONSTEXPR auto Choice() noexcept {
-    return [](std::string_view sv) -> Result {
-        CTPEG_TRACE debug::print("Choice: Failed on input \"", sv, "\".\n");
-        return tl::unexpected<Error_t>(Error_t{"Failed to parse Choice"});
-    };
-}
+template <Parser... Args>
+struct ChoiceParser {
+    using value_type = detail::CommonValue_t<ValueOf_t<Args>...>;
 
-[[nodiscard]] CTPEG_CONSTEXPR auto Choice(Parser auto arg,
-                                          Parser auto... rest) noexcept {
-    return [arg, rest...](std::string_view sv) -> Result {
-        if (auto res = arg(sv)) {
-            CTPEG_TRACE debug::print(
-                "Choice: Successfully parsed input \"", sv,
-                "\". remaining string to parse: ", res.value().second, ".\n");
-            return Result{res.value()};
+    std::tuple<Args...> m_args;
+
+    explicit CTPEG_CONSTEXPR ChoiceParser(Args... args) : m_args(args...) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  value_type &out,
+                                                  auto &...ctx) const {
+        if constexpr (std::same_as<value_type, ResultVariantArray>) {
+            std::size_t n = 0;
+            return extend(sv, out, n, ctx...);
         } else {
-            return Choice(rest...)(sv);
+            return tryEach(
+                sv,
+                [&](const auto &p) {
+                    return detail::parseAs(p, sv, out, ctx...);
+                },
+                ctx...);
         }
-    };
-}
+    }
 
-[[nodiscard]] CTPEG_CONSTEXPR auto Sequence(Parser auto arg,
-                                            Parser auto... rest) noexcept {
-    return [arg, rest...](std::string_view sv) -> Result {
-        auto tmp = detail::SequenceImpl(sv, arg, rest...);
-        ResultVariantArray out;
-        if (tmp) {
-            std::string_view remaining = sv;
-            std::size_t i = 0;
-            for (const auto &[res, rem] : tmp.value()) {
-                remaining = rem;
-                auto single = toVariant<ResultVariantSingle>(res);
-                if (single) {
-                    out[i++] = single.value();
-                } else {
-                    CTPEG_TRACE debug::print(
-                        "Internal Error: Sequence: Failed on input \"", sv,
-                        "\". Could not convert variant\n");
-                    return tl::unexpected<Error_t>(Error_t{
-                        "Internal error: Sequence: Failed to convert variant"});
-                }
+    // The alternative which matches appends its value to the enclosing array
+    // directly, without going through a temporary value_type
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    extend(std::string_view sv, ResultVariantArray &out, std::size_t &n,
+           auto &...ctx) const {
+        return tryEach(
+            sv,
+            [&](const auto &p) {
+                return detail::extend(p, sv, out, n, ctx...);
+            },
+            ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        Remaining res =
+            tl::unexpected<Error_t>(Error_t{"Failed to parse Choice"});
+        std::apply(
+            [&](const auto &...args) {
+                static_cast<void>(
+                    (((res = detail::recognize(args, sv, ctx...)) ||
+                      detail::isFatal(res.error())) ||
+                     ...));
+            },
+            m_args);
+        if (!res && !detail::isFatal(res.error())) {
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse Choice"});
+        }
+        return res;
+    }
+
+private:
+    // Runs the alternatives in order until one of them matches. A fatal error
+    // (see detail::isFatal) stops the Choice, the other alternatives are not
+    // tried.
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining tryEach(std::string_view sv,
+                                                    const auto &run,
+                                                    auto &...ctx) const {
+        // Stays a failure if there are no alternatives
+        Remaining res =
+            tl::unexpected<Error_t>(Error_t{"Failed to parse Choice"});
+        const auto attempt = [&](const auto &arg) {
+            const auto m = detail::mark(ctx...);
+            if ((res = run(arg))) {
+                detail::commit(m, ctx...);
+                return true;
             }
+            detail::rollback(m, ctx...);
+            return detail::isFatal(res.error());
+        };
+        std::apply(
+            [&attempt](const auto &...args) {
+                static_cast<void>((attempt(args) || ...));
+            },
+            m_args);
+        if (!res) {
+            CTPEG_TRACE debug::print("Choice: Failed on input \"", sv, "\".\n");
+            if (detail::isFatal(res.error())) return res;
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse Choice"});
+        }
+        CTPEG_TRACE debug::print("Choice: Successfully parsed input \"", sv,
+                                 "\". remaining string to parse: ", res.value(),
+                                 ".\n");
+        return res;
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Choice(Parser auto... args) noexcept {
+    return std::apply(
+        [](auto... flat) { return ChoiceParser<decltype(flat)...>(flat...); },
+        std::tuple_cat(detail::flatChoice(args)...));
+}
+
+template <Parser... Args>
+struct SequenceParser {
+    using value_type = ResultVariantArray;
+
+    std::tuple<Args...> m_args;
+
+    explicit CTPEG_CONSTEXPR SequenceParser(Args... args) : m_args(args...) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  ResultVariantArray &out,
+                                                  auto &...ctx) const {
+        std::size_t n = 0;
+        return extend(sv, out, n, ctx...);
+    }
+
+    // Every element writes its value straight into `out`, nested sequences
+    // included, so nothing is copied on the way up
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining extend(std::string_view sv,
+                                                   ResultVariantArray &out,
+                                                   std::size_t &n,
+                                                   auto &...ctx) const {
+        const auto first = n;
+        Remaining rem{sv};
+        std::apply(
+            [&](const auto &...args) {
+                static_cast<void>(
+                    ((rem = detail::extend(args, rem.value(), out, n,
+                                           ctx...)) &&
+                     ...));
+            },
+            m_args);
+        if (rem) {
             CTPEG_TRACE debug::print(
                 "Sequence: Successfully parsed input \"", sv,
-                "\". remaining string to parse: ", remaining, ".\n");
-            return std::make_pair(ResultVariantArray{out}, remaining);
+                "\". remaining string to parse: ", rem.value(), ".\n");
         } else {
             CTPEG_TRACE debug::print("Sequence: Failed on input \"", sv,
                                      "\".\n");
-            return tl::unexpected<Error_t>(tmp.error());
+            detail::truncate(out, n, first);
         }
-    };
-}
+        return rem;
+    }
 
-[[nodiscard]] CTPEG_CONSTEXPR auto Many(Parser auto arg) noexcept {
-    return [arg](std::string_view sv) -> Result {
-        std::string_view input = sv;
-        ResultVariantArray out;
-        for (std::size_t i = 0; i < CTPEG_MAX_SEQUENCE_LENGTH; i++) {
-            if (auto res = arg(input)) {
-                if (auto single =
-                        toVariant<ResultVariantSingle>(res.value().first)) {
-                    out[i] = single.value();
-                } else {
-                    CTPEG_TRACE debug::print(
-                        "Internal Error: Many: Failed on input \"", sv,
-                        "\". Could not convert variant\n");
-                    return tl::unexpected<Error_t>(Error_t{
-                        "Internal error: Many: Failed to convert variant"});
-                }
-                input = res.value().second;
-                if (input.empty()) {
-                    CTPEG_TRACE debug::print(
-                        "Many: Successfully parsed input \"", sv,
-                        "\". remaining string to parse: ", input, ".\n");
-                    return std::make_pair(ResultVariantArray{out}, input);
-                }
-            } else {
-                CTPEG_TRACE debug::print(
-                    "Many: Successfully parsed input \"", sv,
-                    "\". remaining string to parse: ", input, ".\n");
-                return std::make_pair(ResultVariantArray{out}, input);
-            }
-        }
-        CTPEG_TRACE debug::print("Internal Error: Many: Failed on input \"", sv,
-                                 "\". Fall through.\n");
-        return tl::unexpected<Error_t>(
-            Error_t{"Internal error: Many: Fall through"});
-    };
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        Remaining rem{sv};
+        std::apply(
+            [&](const auto &...args) {
+                static_cast<void>((
+                    (rem = detail::recognize(args, rem.value(), ctx...)) &&
+                    ...));
+            },
+            m_args);
+        return rem;
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Sequence(Parser auto arg,
+                                            Parser auto... rest) noexcept {
+    return std::apply(
+        [](auto... flat) { return SequenceParser<decltype(flat)...>(flat...); },
+        std::tuple_cat(detail::flatSequence(arg),
+                       detail::flatSequence(rest)...));
 }
 
-[[nodiscard]] CTPEG_CONSTEXPR auto Not(Parser auto arg) noexcept {
-    return [arg](std::string_view sv) -> Result {
-        if (arg(sv)) {
+template <Parser Arg>
+struct NotParser {
+    using value_type = EmptyVariant;
+
+    Arg m_arg;
+
+    explicit CTPEG_CONSTEXPR NotParser(Arg arg) : m_arg(arg) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  EmptyVariant &,
+                                                  auto &...ctx) const {
+        // Lookahead never keeps anything recorded by its argument
+        const auto m = detail::mark(ctx...);
+        ValueOf_t<Arg> value{};
+        const auto ret = detail::parse(m_arg, sv, value, ctx...);
+        detail::rollback(m, ctx...);
+        if (!ret && detail::isFatal(ret.error())) return ret;
+        if (ret) {
             CTPEG_TRACE debug::print("Not: Failed on input \"", sv, "\".\n");
             return tl::unexpected<Error_t>(Error_t{"Failed to parse Not"});
         }
         CTPEG_TRACE debug::print("Not: Successfully parsed input \"", sv,
                                  "\". remaining string to parse: ", sv, ".\n");
-        return {std::make_pair(ResultVariant{EmptyVariant{}}, sv)};
-    };
-}
+        return sv;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        const auto ret = detail::recognize(m_arg, sv, ctx...);
+        if (!ret && detail::isFatal(ret.error())) return ret;
+        if (ret) {
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse Not"});
+        }
+        return sv;
+    }
+};
 
-[[nodiscard]] CTPEG_CONSTEXPR Result Empty(std::string_view sv) noexcept {
-    return {std::make_pair(EmptyVariant{}, sv)};
+[[nodiscard]] CTPEG_CONSTEXPR auto Not(Parser auto arg) noexcept {
+    return NotParser<decltype(arg)>(arg);
 }
 
-[[nodiscard]] CTPEG_CONSTEXPR auto Skip(Parser auto arg) noexcept {
-    return [arg](std::string_view sv) -> Result {
-        if (auto ret = arg(sv)) {
-            CTPEG_TRACE debug::print(
-                "Skip: Successfully parsed input \"", sv,
-                "\". remaining string to parse: ", ret.value().second, ".\n");
-            return std::make_pair(EmptyVariant{}, ret.value().second);
+struct EmptyParser {
+    using value_type = EmptyVariant;
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(bool) const noexcept {
+        return 0;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result
+    operator()(std::string_view sv) const noexcept {
+        return detail::adapt(*this, sv);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view sv, EmptyVariant &) const noexcept {
+        return sv;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv) const noexcept {
+        return sv;
+    }
+};
+
+inline CTPEG_CONSTEXPR EmptyParser Empty{};
+
+template <Parser Arg>
+struct SkipParser {
+    using value_type = EmptyVariant;
+
+    Arg m_arg;
+
+    explicit CTPEG_CONSTEXPR SkipParser(Arg arg) : m_arg(arg) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  EmptyVariant &,
+                                                  auto &...ctx) const {
+        ValueOf_t<Arg> value{};
+        const auto ret = detail::parse(m_arg, sv, value, ctx...);
+        if (ret) {
+            CTPEG_TRACE debug::print("Skip: Successfully parsed input \"", sv,
+                                     "\". remaining string to parse: ",
+                                     ret.value(), ".\n");
         } else {
             CTPEG_TRACE debug::print("Skip: Failed on input \"", sv, "\".\n");
-            return tl::unexpected<Error_t>(ret.error());
         }
-    };
+        return ret;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        return detail::recognize(m_arg, sv, ctx...);
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Skip(Parser auto arg) noexcept {
+    return SkipParser<decltype(arg)>(arg);
+}
+
+// No upper bound on the number of repetitions of Repeat
+inline constexpr std::size_t Unbounded = std::size_t(-1);
+
+// Matches `arg` between Min and Max times, with `sep` between every two of
+// them. The values of `arg` are collected in an array, those of `sep` are
+// dropped. Fold goes over the elements one at a time instead.
+// An element which matches without consuming any input ends the repetition,
+// as it would otherwise match forever.
+template <std::size_t Min, std::size_t Max, Parser Arg, Parser Sep>
+struct RepeatParser {
+    using value_type = ResultVariantArray;
+
+    Arg m_arg;
+    Sep m_sep;
+
+    explicit CTPEG_CONSTEXPR RepeatParser(Arg arg, Sep sep)
+        : m_arg(arg), m_sep(sep) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  ResultVariantArray &out,
+                                                  auto &...ctx) const {
+        std::size_t n = 0;
+        return extend(sv, out, n, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining extend(std::string_view sv,
+                                                   ResultVariantArray &out,
+                                                   std::size_t &n,
+                                                   auto &...ctx) const {
+        const auto first = n;
+        auto ret = repeat(
+            sv,
+            [&](std::string_view in) {
+                return detail::extend(m_arg, in, out, n, ctx...);
+            },
+            ctx...);
+        if (!ret) detail::truncate(out, n, first);
+        return ret;
+    }
+
+    // Calls `fn` with the value of every element as soon as it is matched.
+    // Nothing is stored, so the number of elements is not limited by
+    // CTPEG_MAX_SEQUENCE_LENGTH.
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining each(std::string_view sv,
+                                                 const auto &fn,
+                                                 auto &...ctx) const {
+        return repeat(
+            sv,
+            [&](std::string_view in) {
+                ValueOf_t<Arg> value{};
+                auto res = detail::parse(m_arg, in, value, ctx...);
+                if (res) fn(value);
+                return res;
+            },
+            ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(bool) const noexcept {
+        return 1;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        std::string_view input = sv;
+        std::size_t count = 0;
+        while (count < Max) {
+            Remaining res{input};
+            if (count != 0) res = detail::recognize(m_sep, input, ctx...);
+            if (res) res = detail::recognize(m_arg, res.value(), ctx...);
+            if (!res) {
+                if (detail::isFatal(res.error())) return res;
+                break;
+            }
+            count++;
+            const bool progressed = res.value().size() != input.size();
+            input = res.value();
+            if (!progressed || (input.empty() && count >= Min)) break;
+        }
+        if (count < Min) {
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse Repeat"});
+        }
+        return input;
+    }
+
+private:
+    // Runs `step` on the input left after each separator, `step` matches a
+    // single element
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining repeat(std::string_view sv,
+                                                   const auto &step,
+                                                   auto &...ctx) const {
+        std::string_view input = sv;
+        std::size_t count = 0;
+        while (count < Max) {
+            const auto m = detail::mark(ctx...);
+            Remaining res{input};
+            if constexpr (!std::same_as<Sep, EmptyParser>) {
+                if (count != 0) {
+                    ValueOf_t<Sep> sep{};
+                    res = detail::parse(m_sep, input, sep, ctx...);
+                }
+            }
+            if (res) res = step(res.value());
+            if (!res) {
+                detail::rollback(m, ctx...);
+                if (detail::isFatal(res.error())) {
+                    CTPEG_TRACE debug::print("Repeat: Failed on input \"", sv,
+                                             "\".\n");
+                    return res;
+                }
+                break;
+            }
+            detail::commit(m, ctx...);
+            count++;
+            const bool progressed = res.value().size() != input.size();
+            input = res.value();
+            if (!progressed) break;
+            if (input.empty() && count >= Min) {
+                // Stopping here depends on there being no more input
+                detail::observe(*this, sv, res, ctx...);
+                break;
+            }
+        }
+        if (count < Min) {
+            CTPEG_TRACE debug::print("Repeat: Failed on input \"", sv,
+                                     "\". Matched ", count, " of ", Min,
+                                     " elements.\n");
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse Repeat"});
+        }
+        CTPEG_TRACE debug::print("Repeat: Successfully parsed input \"", sv,
+                                 "\". remaining string to parse: ", input,
+                                 ".\n");
+        return input;
+    }
+};
+
+template <Parser Arg>
+using ManyParser = RepeatParser<0, Unbounded, Arg, EmptyParser>;
+
+template <std::size_t Min, std::size_t Max = Min>
+[[nodiscard]] CTPEG_CONSTEXPR auto Repeat(Parser auto arg,
+                                          Parser auto sep) noexcept {
+    static_assert(Min <= Max, "Repeat: Min is greater than Max");
+    return RepeatParser<Min, Max, decltype(arg), decltype(sep)>(arg, sep);
+}
+
+template <std::size_t Min, std::size_t Max = Min>
+[[nodiscard]] CTPEG_CONSTEXPR auto Repeat(Parser auto arg) noexcept {
+    return Repeat<Min, Max>(arg, Empty);
+}
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Many(Parser auto arg) noexcept {
+    return Repeat<0, Unbounded>(arg);
+}
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Many1(Parser auto arg) noexcept {
+    return Repeat<1, Unbounded>(arg);
+}
+
+// Zero or more `arg` separated by `sep`, e.g. `SepBy(Int(), Char(','))`.
+// A trailing separator is not consumed.
+[[nodiscard]] CTPEG_CONSTEXPR auto SepBy(Parser auto arg,
+                                         Parser auto sep) noexcept {
+    return Repeat<0, Unbounded>(arg, sep);
+}
+
+// Combines the values of the elements of a repetition as they are parsed,
+// starting from `init`: `acc = fn(acc, value)`. Only the accumulator is kept,
+// so lists of any length can be reduced, e.g.
+//   Fold(SepBy(Int(), Char(',')), int64_t{0}, std::plus<>{})
+// Parsers other than Many, Many1, Repeat and SepBy are repeated as by Many.
+// Like Action, `fn` is not called when only recognising input.
+template <typename Rep, typename T, typename Fn>
+struct FoldParser {
+    using value_type = T;
+
+    Rep m_rep;
+    T m_init;
+    Fn m_fn;
+
+    explicit CTPEG_CONSTEXPR FoldParser(Rep rep, T init, Fn fn)
+        : m_rep(rep), m_init(init), m_fn(fn) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv, T &out,
+                                                  auto &...ctx) const {
+        T acc = m_init;
+        auto ret = m_rep.each(
+            sv, [&](const auto &value) { acc = m_fn(acc, value); }, ctx...);
+        if (ret) out = acc;
+        return ret;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        return m_rep.recognize(sv, ctx...);
+    }
+};
+
+template <std::size_t Min, std::size_t Max, Parser Arg, Parser Sep>
+[[nodiscard]] CTPEG_CONSTEXPR auto Fold(RepeatParser<Min, Max, Arg, Sep> rep,
+                                        auto init, auto fn) noexcept {
+    return FoldParser<decltype(rep), decltype(init), decltype(fn)>(rep, init,
+                                                                   fn);
+}
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Fold(Parser auto arg, auto init,
+                                        auto fn) noexcept {
+    return Fold(Many(arg), init, fn);
 }
 
 [[nodiscard]] CTPEG_CONSTEXPR auto Maybe(Parser auto arg) noexcept {
@@ -393,13 +1089,26 @@ inline namespace v0_3_1 {
 }
 
 struct Char {
+    using value_type = char;
+
     std::optional<char> m_c;
     explicit CTPEG_CONSTEXPR Char(char c) : m_c(c) {}
 
     explicit CTPEG_CONSTEXPR Char() : m_c() {}
 
+    // How many characters the parser could have read past the ones it matched
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(
+        bool matched) const noexcept {
+        return matched ? 0 : 1;
+    }
+
     [[nodiscard]] CTPEG_CONSTEXPR Result
     operator()(std::string_view arg) const noexcept {
+        return detail::adapt(*this, arg);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view arg, char &out) const noexcept {
         if (arg.empty()) {
             CTPEG_TRACE debug::print("Char: Failed on empty input.\n");
             return tl::unexpected<Error_t>(
@@ -409,47 +1118,100 @@ struct Char {
             CTPEG_TRACE debug::print(
                 "Char: Successfully parsed input \"", arg,
                 "\". remaining string to parse: ", arg.substr(1), ".\n");
-            return std::make_pair(ResultVariant{arg[0]}, arg.substr(1));
+            out = arg[0];
+            return arg.substr(1);
         }
 
         if (arg[0] == m_c.value()) {
             CTPEG_TRACE debug::print(
                 "Char(", m_c.value(), "): Successfully parsed input \"", arg,
                 "\". remaining string to parse: ", arg.substr(1), ".\n");
-            return std::make_pair(ResultVariant{m_c.value()}, arg.substr(1));
+            out = m_c.value();
+            return arg.substr(1);
         } else {
             CTPEG_TRACE debug::print("Char(", m_c.value(),
                                      "): Failed on input \"", arg, "\".\n");
             return tl::unexpected<Error_t>(Error_t{"Failed to parse Char"});
         }
     }
-};
 
-[[nodiscard]] CTPEG_CONSTEXPR auto Final(Parser auto arg) noexcept {
-    return [arg](std::string_view sv) -> Result {
-        if (auto ret = Sequence(arg, Not(Char()))(sv)) {
-            CTPEG_TRACE debug::print("Final: Successfully parsed input \"", sv,
-                                     "\".\n");
-            const auto arr = std::get<ResultVariantArray>(ret.value().first);
-            if (auto res = toVariant<ResultVariant>(arr[0])) {
-                return std::make_pair(res.value(), ret.value().second);
-            } else {
-                return tl::unexpected<Error_t>(Error_t{
-                    "Internal error: Final: Failed to convert variant"});
-            }
-        } else {
-            CTPEG_TRACE debug::print("Final: Failed on input \"", sv, "\".\n");
-            return tl::unexpected<Error_t>(ret.error());
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view arg) const noexcept {
+        if (arg.empty()) {
+            return tl::unexpected<Error_t>(
+                Error_t{"Could not parse Char with empty input"});
         }
-    };
+        if (m_c && arg[0] != m_c.value()) {
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse Char"});
+        }
+        return arg.substr(1);
+    }
+};
+
+template <Parser Arg>
+struct FinalParser {
+    using value_type = ValueOf_t<Arg>;
+
+    Arg m_arg;
+
+    explicit CTPEG_CONSTEXPR FinalParser(Arg arg) : m_arg(arg) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  value_type &out,
+                                                  auto &...ctx) const {
+        auto ret = detail::parse(m_arg, sv, out, ctx...);
+        if (ret) {
+            EmptyVariant none{};
+            auto end = detail::parse(Not(Char()), ret.value(), none, ctx...);
+            if (end) {
+                CTPEG_TRACE debug::print("Final: Successfully parsed input \"",
+                                         sv, "\".\n");
+                return ret;
+            }
+            CTPEG_TRACE debug::print("Final: Failed on input \"", sv, "\".\n");
+            return tl::unexpected<Error_t>(end.error());
+        }
+        CTPEG_TRACE debug::print("Final: Failed on input \"", sv, "\".\n");
+        return ret;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        auto ret = detail::recognize(m_arg, sv, ctx...);
+        if (ret && !ret.value().empty()) {
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse Not"});
+        }
+        return ret;
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Final(Parser auto arg) noexcept {
+    return FinalParser<decltype(arg)>(arg);
 }
 
 struct String {
+    using value_type = std::string_view;
+
     std::string_view m_sv;
     explicit CTPEG_CONSTEXPR String(std::string_view sv) : m_sv(sv) {}
 
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(
+        bool matched) const noexcept {
+        return matched ? 0 : m_sv.size();
+    }
+
     [[nodiscard]] CTPEG_CONSTEXPR Result
     operator()(std::string_view arg) const noexcept {
+        return detail::adapt(*this, arg);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view arg, std::string_view &out) const noexcept {
         if (m_sv.size() > arg.size()) {
             CTPEG_TRACE debug::print("String(", m_sv, "): Failed on input \"",
                                      arg, "\". Input too short.\n");
@@ -461,21 +1223,46 @@ struct String {
                 "String(", m_sv, "): Successfully parsed input \"", arg,
                 "\". remaining string to parse: ", arg.substr(m_sv.size()),
                 ".\n");
-            return std::make_pair(ResultVariant{m_sv}, arg.substr(m_sv.size()));
+            out = m_sv;
+            return arg.substr(m_sv.size());
         }
         CTPEG_TRACE debug::print("String(", m_sv, "): Failed on input \"", arg,
                                  "\".\n");
         return tl::unexpected<Error_t>(Error_t{"Failed to parse String"});
     }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view arg) const noexcept {
+        if (m_sv.size() > arg.size()) {
+            return tl::unexpected<Error_t>(
+                Error_t{"Unexpected end of input when parsing String"});
+        }
+        if (arg.substr(0, m_sv.size()) != m_sv) {
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse String"});
+        }
+        return arg.substr(m_sv.size());
+    }
 };
 
 struct Digit {
+    using value_type = int64_t;
+
     std::optional<int64_t> m_i;
     explicit CTPEG_CONSTEXPR Digit(int64_t i) : m_i(i) {}
     explicit CTPEG_CONSTEXPR Digit() : m_i() {}
 
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(
+        bool matched) const noexcept {
+        return matched ? 0 : 1;
+    }
+
     [[nodiscard]] CTPEG_CONSTEXPR Result
     operator()(std::string_view arg) const noexcept {
+        return detail::adapt(*this, arg);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view arg, int64_t &out) const noexcept {
         if (arg.empty())
             return tl::unexpected<Error_t>(
                 Error_t{"Unexpected end of input when parsing Digit"});
@@ -485,8 +1272,8 @@ struct Digit {
                 CTPEG_TRACE debug::print(
                     "Digit: Successfully parsed input \"", arg,
                     "\". remaining string to parse: ", arg.substr(1), ".\n");
-                return std::make_pair(ResultVariant{detail::charToInt(arg[0])},
-                                      arg.substr(1));
+                out = detail::charToInt(arg[0]);
+                return arg.substr(1);
             } else {
                 CTPEG_TRACE debug::print("Digit: Failed on input \"", arg,
                                          "\".\n");
@@ -499,23 +1286,52 @@ struct Digit {
             CTPEG_TRACE debug::print(
                 "Digit(", m_i.value(), "): Successfully parsed input \"", arg,
                 "\". remaining string to parse: ", arg.substr(1), ".\n");
-            return std::make_pair(ResultVariant{m_i.value()}, arg.substr(1));
+            out = m_i.value();
+            return arg.substr(1);
         } else {
             CTPEG_TRACE debug::print("Digit(", m_i.value(),
                                      "): Failed on input \"", arg, "\".\n");
             return tl::unexpected<Error_t>(Error_t{"Failed to parse Digit"});
         }
     }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view arg) const noexcept {
+        if (arg.empty())
+            return tl::unexpected<Error_t>(
+                Error_t{"Unexpected end of input when parsing Digit"});
+        if (m_i ? arg[0] != detail::digitToChar(m_i.value())
+                : !detail::isdigit(arg[0])) {
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse Digit"});
+        }
+        return arg.substr(1);
+    }
 };
 
 struct Int {
+    using value_type = int64_t;
+
     std::optional<int64_t> m_i;
     explicit CTPEG_CONSTEXPR Int(int64_t i) : m_i(i) {}
 
     CTPEG_CONSTEXPR Int() : m_i() {}
 
+    // Int() reads up to the first character which is not a digit
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(
+        bool matched) const noexcept {
+        if (!m_i) return 1;
+        return matched ? 0
+                       : static_cast<std::size_t>(
+                             detail::getNumDigits(m_i.value()));
+    }
+
     [[nodiscard]] CTPEG_CONSTEXPR Result
     operator()(std::string_view arg) const noexcept {
+        return detail::adapt(*this, arg);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view arg, int64_t &out) const noexcept {
         if (!m_i) {
             std::size_t i = 0;
             for (char ch : arg) {
@@ -533,8 +1349,8 @@ struct Int {
             CTPEG_TRACE debug::print(
                 "Int: Successfully parsed input \"", arg,
                 "\". remaining string to parse: ", arg.substr(i), ".\n");
-            return std::make_pair(detail::svToInt(arg.substr(0, i)),
-                                  arg.substr(i));
+            out = detail::svToInt(arg.substr(0, i));
+            return arg.substr(i);
         }
         const auto numDigits =
             static_cast<size_t>(detail::getNumDigits(m_i.value()));
@@ -557,11 +1373,182 @@ struct Int {
         CTPEG_TRACE debug::print(
             "Int(", m_i.value(), "): Successfully parsed input \"", arg,
             "\". remaining string to parse: ", arg.substr(numDigits), ".\n");
-        return std::make_pair(ResultVariant{m_i.value()},
-                              arg.substr(numDigits));
+        out = m_i.value();
+        return arg.substr(numDigits);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view arg) const noexcept {
+        std::size_t i = 0;
+        if (!m_i) {
+            while (i < arg.size() && detail::isdigit(arg[i])) i++;
+            if (i == 0) {
+                return tl::unexpected<Error_t>(Error_t{"Failed to parse Int"});
+            }
+            return arg.substr(i);
+        }
+        const auto numDigits =
+            static_cast<size_t>(detail::getNumDigits(m_i.value()));
+        if (arg.size() < numDigits) {
+            return tl::unexpected<Error_t>(
+                Error_t{"Failed to parse Int: Input is too short"});
+        }
+        for (std::size_t digitCounter = numDigits - 1; i < numDigits;
+             digitCounter--, i++) {
+            if (detail::digitToChar(detail::nthDigit(
+                    m_i.value(), digitCounter)) != arg[i]) {
+                return tl::unexpected<Error_t>(Error_t{"Failed to parse Int"});
+            }
+        }
+        return arg.substr(numDigits);
+    }
+};
+
+// Matches a single character out of a set, looked up in a 256 bit table.
+// The set is given like the inside of a regex bracket expression, e.g. "a-z_".
+struct CharClass {
+    using value_type = char;
+
+    std::array<std::uint64_t, 4> m_set{};
+
+    explicit CTPEG_CONSTEXPR CharClass(std::array<std::uint64_t, 4> set)
+        : m_set(set) {}
+
+    explicit CTPEG_CONSTEXPR CharClass(std::string_view ranges) {
+        for (std::size_t i = 0; i < ranges.size(); i++) {
+            auto last = ranges[i];
+            if (i + 2 < ranges.size() && ranges[i + 1] == '-') {
+                last = ranges[i + 2];
+            }
+            for (auto c = static_cast<unsigned char>(ranges[i]);
+                 c <= static_cast<unsigned char>(last); c++) {
+                m_set[c >> 6] |= std::uint64_t{1} << (c & 63);
+                if (c == 255) break;
+            }
+            if (last != ranges[i]) i += 2;
+        }
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR bool contains(char c) const noexcept {
+        const auto u = static_cast<unsigned char>(c);
+        return (m_set[u >> 6] >> (u & 63)) & 1;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(
+        bool matched) const noexcept {
+        return matched ? 0 : 1;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result
+    operator()(std::string_view arg) const noexcept {
+        return detail::adapt(*this, arg);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view arg, char &out) const noexcept {
+        if (arg.empty() || !contains(arg[0])) {
+            CTPEG_TRACE debug::print("CharClass: Failed on input \"", arg,
+                                     "\".\n");
+            return tl::unexpected<Error_t>(
+                Error_t{"Failed to parse CharClass"});
+        }
+        CTPEG_TRACE debug::print(
+            "CharClass: Successfully parsed input \"", arg,
+            "\". remaining string to parse: ", arg.substr(1), ".\n");
+        out = arg[0];
+        return arg.substr(1);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view arg) const noexcept {
+        if (arg.empty() || !contains(arg[0])) {
+            return tl::unexpected<Error_t>(
+                Error_t{"Failed to parse CharClass"});
+        }
+        return arg.substr(1);
+    }
+};
+
+// Applies `fn` to the value produced by `arg`. `fn` has to be free of side
+// effects: it is not called at all when the parser is only recognising input.
+template <Parser Arg, typename Fn>
+struct ActionParser {
+    // Whatever `fn` returns, as long as it can be given a slot
+    using value_type = std::conditional_t<
+        std::default_initializable<std::remove_cvref_t<
+            std::invoke_result_t<const Fn &, const ResultVariant &>>>,
+        std::remove_cvref_t<
+            std::invoke_result_t<const Fn &, const ResultVariant &>>,
+        ResultVariant>;
+
+    Arg m_arg;
+    Fn m_fn;
+
+    explicit CTPEG_CONSTEXPR ActionParser(Arg arg, Fn fn)
+        : m_arg(arg), m_fn(fn) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  value_type &out,
+                                                  auto &...ctx) const {
+        ValueOf_t<Arg> value{};
+        if (auto ret = detail::parse(m_arg, sv, value, ctx...)) {
+            CTPEG_TRACE debug::print(
+                "Action: Successfully parsed input \"", sv,
+                "\". remaining string to parse: ", ret.value(), ".\n");
+            detail::assign(out, m_fn(detail::toResultVariant(value)));
+            return ret;
+        } else {
+            CTPEG_TRACE debug::print("Action: Failed on input \"", sv, "\".\n");
+            return ret;
+        }
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        return detail::recognize(m_arg, sv, ctx...);
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Action(Parser auto arg, auto fn) noexcept {
+    return ActionParser<decltype(arg), decltype(fn)>(arg, fn);
+}
+
+class DepthLimit;
+
+template <Parser Arg>
+struct Recognizer {
+    Arg m_arg;
+
+    explicit CTPEG_CONSTEXPR Recognizer(Arg arg) : m_arg(arg) {}
+
+    // Returns the number of characters matched
+    [[nodiscard]] CTPEG_CONSTEXPR ErrorOr<std::size_t> operator()(
+        std::string_view sv) const noexcept {
+        if (auto ret = detail::recognize(m_arg, sv)) {
+            return sv.size() - ret.value().size();
+        } else {
+            return tl::unexpected<Error_t>(ret.error());
+        }
     }
+
+    // Same, but fails with TooDeep once `limit` is exceeded
+    [[nodiscard]] CTPEG_CONSTEXPR ErrorOr<std::size_t> operator()(
+        std::string_view sv, DepthLimit &limit) const noexcept;
 };
 
+// Validates input against the grammar without building any values. Returns how
+// much of the input was matched. Actions are skipped, user defined parsers
+// (e.g. plain functions) can not be looked into and are run in full. Pass a
+// DepthLimit to bound the nesting of recursive rules.
+[[nodiscard]] CTPEG_CONSTEXPR auto Recognize(Parser auto arg) noexcept {
+    return Recognizer<decltype(arg)>(arg);
+}
+
 [[nodiscard]] constexpr auto nextNonEmpty(
     ResultVariantArray::const_iterator arr,
     ResultVariantArray::const_iterator end) noexcept {
@@ -598,6 +1585,2487 @@ template <typename To, typename From>
         },
         a);
 }
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+/*
+/////////////////////////////////////
+////////// Binary primitives ////////
+/////////////////////////////////////
+ */
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Reads an integer of type T stored in sizeof(T) bytes in the byte order
+// `Order`. The value is widened to int64_t, so 64 bit unsigned values above
+// INT64_MAX wrap around. When given a value, only that value is matched (e.g. a
+// magic number).
+template <std::integral T, std::endian Order>
+struct FixedInt {
+    using value_type = int64_t;
+    using int_type = T;
+    static constexpr std::size_t width = sizeof(T);
+
+    std::optional<T> m_value;
+    explicit CTPEG_CONSTEXPR FixedInt(T value) : m_value(value) {}
+    explicit CTPEG_CONSTEXPR FixedInt() : m_value() {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(
+        bool matched) const noexcept {
+        return matched ? 0 : width;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result
+    operator()(std::string_view arg) const noexcept {
+        return detail::adapt(*this, arg);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view arg, int64_t &out) const noexcept {
+        const auto value = read(arg);
+        if (!value) {
+            CTPEG_TRACE debug::print("FixedInt: Failed on input \"", arg,
+                                     "\". Input too short.\n");
+            return tl::unexpected<Error_t>(
+                Error_t{"Unexpected end of input when parsing FixedInt"});
+        }
+        if (m_value && value.value() != m_value.value()) {
+            CTPEG_TRACE debug::print("FixedInt(", m_value.value(),
+                                     "): Failed on input \"", arg, "\".\n");
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse FixedInt"});
+        }
+        CTPEG_TRACE debug::print(
+            "FixedInt: Successfully parsed input \"", arg,
+            "\". remaining string to parse: ", arg.substr(width), ".\n");
+        out = static_cast<int64_t>(value.value());
+        return arg.substr(width);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view arg) const noexcept {
+        const auto value = read(arg);
+        if (!value) {
+            return tl::unexpected<Error_t>(
+                Error_t{"Unexpected end of input when parsing FixedInt"});
+        }
+        if (m_value && value.value() != m_value.value()) {
+            return tl::unexpected<Error_t>(Error_t{"Failed to parse FixedInt"});
+        }
+        return arg.substr(width);
+    }
+
+    // Decodes the integer at the start of `arg`, nothing if it is too short
+    [[nodiscard]] static CTPEG_CONSTEXPR std::optional<T> read(
+        std::string_view arg) noexcept {
+        if (arg.size() < width) return std::nullopt;
+        // Unrolled, so that compilers turn it into one load (and byte swap)
+        std::uint64_t bits = 0;
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((bits |= std::uint64_t{static_cast<unsigned char>(arg[I])}
+                      << 8 * (Order == std::endian::big ? width - 1 - I : I)),
+             ...);
+        }(std::make_index_sequence<width>{});
+        return static_cast<T>(bits);
+    }
+};
+
+using U8 = FixedInt<std::uint8_t, std::endian::little>;
+using I8 = FixedInt<std::int8_t, std::endian::little>;
+using U16LE = FixedInt<std::uint16_t, std::endian::little>;
+using U16BE = FixedInt<std::uint16_t, std::endian::big>;
+using I16LE = FixedInt<std::int16_t, std::endian::little>;
+using I16BE = FixedInt<std::int16_t, std::endian::big>;
+using U32LE = FixedInt<std::uint32_t, std::endian::little>;
+using U32BE = FixedInt<std::uint32_t, std::endian::big>;
+using I32LE = FixedInt<std::int32_t, std::endian::little>;
+using I32BE = FixedInt<std::int32_t, std::endian::big>;
+using U64LE = FixedInt<std::uint64_t, std::endian::little>;
+using U64BE = FixedInt<std::uint64_t, std::endian::big>;
+using I64LE = FixedInt<std::int64_t, std::endian::little>;
+using I64BE = FixedInt<std::int64_t, std::endian::big>;
+
+// Matches the next N bytes, whatever they are. The value is a view of them in
+// the input, nothing is copied.
+template <std::size_t N>
+struct Bytes {
+    using value_type = std::string_view;
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(
+        bool matched) const noexcept {
+        return matched ? 0 : N;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result
+    operator()(std::string_view arg) const noexcept {
+        return detail::adapt(*this, arg);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view arg, std::string_view &out) const noexcept {
+        if (arg.size() < N) {
+            CTPEG_TRACE debug::print("Bytes(", N, "): Failed on input \"", arg,
+                                     "\". Input too short.\n");
+            return tl::unexpected<Error_t>(
+                Error_t{"Unexpected end of input when parsing Bytes"});
+        }
+        out = arg.substr(0, N);
+        return arg.substr(N);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view arg) const noexcept {
+        if (arg.size() < N) {
+            return tl::unexpected<Error_t>(
+                Error_t{"Unexpected end of input when parsing Bytes"});
+        }
+        return arg.substr(N);
+    }
+};
+
+// Reads a length with Len (an unsigned FixedInt, e.g. U16BE) and matches that
+// many bytes after it. The value is a view of those bytes in the input, without
+// the length.
+template <typename Len>
+    requires std::unsigned_integral<typename Len::int_type>
+struct LengthPrefixed {
+    using value_type = std::string_view;
+
+    // A failed match may have looked as far as the longest payload
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(
+        bool matched) const noexcept {
+        constexpr auto most =
+            std::numeric_limits<typename Len::int_type>::max();
+        constexpr auto cap = std::numeric_limits<std::size_t>::max() / 2;
+        constexpr auto longest =
+            most < cap ? static_cast<std::size_t>(most) : cap;
+        return matched ? 0 : Len::width + longest;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result
+    operator()(std::string_view arg) const noexcept {
+        return detail::adapt(*this, arg);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view arg, std::string_view &out) const noexcept {
+        auto ret = recognize(arg);
+        if (!ret) {
+            CTPEG_TRACE debug::print("LengthPrefixed: Failed on input \"", arg,
+                                     "\". Input too short.\n");
+            return ret;
+        }
+        out = arg.substr(Len::width, arg.size() - ret.value().size() -
+                                         Len::width);
+        return ret;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view arg) const noexcept {
+        const auto length = Len::read(arg);
+        if (!length || arg.size() - Len::width < length.value()) {
+            return tl::unexpected<Error_t>(
+                Error_t{"Unexpected end of input when parsing LengthPrefixed"});
+        }
+        return arg.substr(Len::width +
+                          static_cast<std::size_t>(length.value()));
+    }
+};
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+/*
+/////////////////////////////////////
+///////// Regular sub-grammars //////
+/////////////////////////////////////
+ */
+
+#ifndef CTPEG_MAX_DFA_STATES
+#define CTPEG_MAX_DFA_STATES 32
+#endif
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+template <typename Pattern, std::size_t N>
+struct LongestMatchParser;
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+namespace ctpeg::detail {
+inline namespace v0_3_1 {
+
+// Whether P is built only out of parsers which can be turned into a DFA, i.e.
+// without recursion, actions, lookahead or user defined parsers
+template <typename P>
+constexpr bool IsRegular_v = false;
+
+template <>
+constexpr bool IsRegular_v<Char> = true;
+
+template <>
+constexpr bool IsRegular_v<CharClass> = true;
+
+template <>
+constexpr bool IsRegular_v<String> = true;
+
+template <>
+constexpr bool IsRegular_v<Digit> = true;
+
+template <>
+constexpr bool IsRegular_v<EmptyParser> = true;
+
+template <std::size_t N>
+constexpr bool IsRegular_v<Bytes<N>> = true;
+
+template <std::integral T, std::endian Order>
+constexpr bool IsRegular_v<FixedInt<T, Order>> = true;
+
+template <typename... Args>
+constexpr bool IsRegular_v<ChoiceParser<Args...>> = (IsRegular_v<Args> && ...);
+
+template <typename... Args>
+constexpr bool IsRegular_v<SequenceParser<Args...>> =
+    (IsRegular_v<Args> && ...);
+
+template <std::size_t Min, std::size_t Max, typename Arg, typename Sep>
+constexpr bool IsRegular_v<RepeatParser<Min, Max, Arg, Sep>> =
+    IsRegular_v<Arg> && IsRegular_v<Sep>;
+
+template <typename Arg>
+constexpr bool IsRegular_v<SkipParser<Arg>> = IsRegular_v<Arg>;
+
+template <typename Pattern, std::size_t N>
+constexpr bool IsRegular_v<LongestMatchParser<Pattern, N>> = true;
+
+using ByteSet = std::array<std::uint64_t, 4>;
+
+inline constexpr ByteSet AnyByte{~std::uint64_t{0}, ~std::uint64_t{0},
+                                 ~std::uint64_t{0}, ~std::uint64_t{0}};
+
+[[nodiscard]] CTPEG_CONSTEXPR ByteSet byteSet(unsigned char c) noexcept {
+    ByteSet set{};
+    set[c >> 6] |= std::uint64_t{1} << (c & 63);
+    return set;
+}
+
+[[nodiscard]] CTPEG_CONSTEXPR bool contains(const ByteSet &set,
+                                            unsigned char c) noexcept {
+    return (set[c >> 6] >> (c & 63)) & 1;
+}
+
+// Nondeterministic automaton of a regular parser. Each parser adds the states
+// between the byte it starts at and the one it ends at.
+class Nfa {
+public:
+    struct Edge {
+        ByteSet set;
+        std::size_t to;
+    };
+
+private:
+    // For every state, the states it reaches by reading a byte and without
+    // reading anything
+    std::vector<std::vector<Edge>> m_edges{};
+    std::vector<std::vector<std::size_t>> m_epsilons{};
+
+public:
+    CTPEG_CONSTEXPR std::size_t add() {
+        m_edges.emplace_back();
+        m_epsilons.emplace_back();
+        return m_edges.size() - 1;
+    }
+
+    CTPEG_CONSTEXPR void epsilon(std::size_t from, std::size_t to) {
+        m_epsilons[from].push_back(to);
+    }
+
+    // Adds a state reached from `from` by one of the bytes in `set`
+    CTPEG_CONSTEXPR std::size_t bytes(std::size_t from, const ByteSet &set) {
+        const auto to = add();
+        m_edges[from].push_back(Edge{set, to});
+        return to;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t size() const noexcept {
+        return m_edges.size();
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR const std::vector<Edge> &edges(
+        std::size_t s) const noexcept {
+        return m_edges[s];
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR const std::vector<std::size_t> &epsilons(
+        std::size_t s) const noexcept {
+        return m_epsilons[s];
+    }
+
+    // Adds the states matching the parser after `from`, returns the state it
+    // ends at
+    CTPEG_CONSTEXPR std::size_t build(const Char &p, std::size_t from) {
+        return bytes(from, p.m_c ? byteSet(static_cast<unsigned char>(
+                                       p.m_c.value()))
+                                 : AnyByte);
+    }
+
+    CTPEG_CONSTEXPR std::size_t build(const CharClass &p, std::size_t from) {
+        return bytes(from, p.m_set);
+    }
+
+    CTPEG_CONSTEXPR std::size_t build(const String &p, std::size_t from) {
+        for (const auto c : p.m_sv) {
+            from = bytes(from, byteSet(static_cast<unsigned char>(c)));
+        }
+        return from;
+    }
+
+    CTPEG_CONSTEXPR std::size_t build(const Digit &p, std::size_t from) {
+        if (p.m_i) {
+            return bytes(from, byteSet(static_cast<unsigned char>(
+                                   digitToChar(p.m_i.value()))));
+        }
+        ByteSet digits{};
+        for (unsigned char c = '0'; c <= '9'; c++) digits[0] |= byteSet(c)[0];
+        return bytes(from, digits);
+    }
+
+    CTPEG_CONSTEXPR std::size_t build(const EmptyParser &, std::size_t from) {
+        return from;
+    }
+
+    template <std::size_t N>
+    CTPEG_CONSTEXPR std::size_t build(const Bytes<N> &, std::size_t from) {
+        for (std::size_t i = 0; i < N; i++) from = bytes(from, AnyByte);
+        return from;
+    }
+
+    template <std::integral T, std::endian Order>
+    CTPEG_CONSTEXPR std::size_t build(const FixedInt<T, Order> &p,
+                                      std::size_t from) {
+        for (std::size_t i = 0; i < sizeof(T); i++) {
+            if (!p.m_value) {
+                from = bytes(from, AnyByte);
+                continue;
+            }
+            const auto shift =
+                8 * (Order == std::endian::big ? sizeof(T) - 1 - i : i);
+            const auto bits = static_cast<std::uint64_t>(p.m_value.value());
+            from = bytes(from, byteSet(static_cast<unsigned char>(
+                                   (bits >> shift) & 0xff)));
+        }
+        return from;
+    }
+
+    template <typename... Args>
+    CTPEG_CONSTEXPR std::size_t build(const ChoiceParser<Args...> &p,
+                                      std::size_t from) {
+        const auto to = add();
+        std::apply(
+            [&](const auto &...args) {
+                (epsilon(build(args, branch(from)), to), ...);
+            },
+            p.m_args);
+        return to;
+    }
+
+    template <typename... Args>
+    CTPEG_CONSTEXPR std::size_t build(const SequenceParser<Args...> &p,
+                                      std::size_t from) {
+        std::apply(
+            [&](const auto &...args) { ((from = build(args, from)), ...); },
+            p.m_args);
+        return from;
+    }
+
+    template <std::size_t Min, std::size_t Max, typename Arg, typename Sep>
+    CTPEG_CONSTEXPR std::size_t build(const RepeatParser<Min, Max, Arg, Sep> &p,
+                                      std::size_t from) {
+        const auto item = [&](std::size_t count, std::size_t at) {
+            if (count != 0) at = build(p.m_sep, at);
+            return build(p.m_arg, at);
+        };
+        std::size_t count = 0;
+        for (; count < Min; count++) from = item(count, from);
+        const auto to = add();
+        epsilon(from, to);
+        if constexpr (Max == Unbounded) {
+            // After the first element, loop over the following ones
+            if (count == 0) {
+                from = item(count++, from);
+                epsilon(from, to);
+            }
+            epsilon(item(count, branch(from)), from);
+        } else {
+            for (; count < Max; count++) {
+                from = item(count, from);
+                epsilon(from, to);
+            }
+        }
+        return to;
+    }
+
+    template <typename Arg>
+    CTPEG_CONSTEXPR std::size_t build(const SkipParser<Arg> &p,
+                                      std::size_t from) {
+        return build(p.m_arg, from);
+    }
+
+    template <typename Pattern, std::size_t N>
+    CTPEG_CONSTEXPR std::size_t build(const LongestMatchParser<Pattern, N> &,
+                                      std::size_t from) {
+        return build(Pattern{}(), from);
+    }
+
+private:
+    // A new state entered from `from` without reading anything
+    CTPEG_CONSTEXPR std::size_t branch(std::size_t from) {
+        const auto to = add();
+        epsilon(from, to);
+        return to;
+    }
+};
+
+// Minimised DFA with a row of 256 transitions per state. State 0 is the dead
+// state, the accepting states are numbered from `firstAccepting` up.
+template <typename State, std::size_t N>
+struct Dfa {
+    static constexpr std::size_t Unlimited =
+        std::numeric_limits<std::size_t>::max() / 2;
+
+    std::array<std::array<State, 256>, N> table{};
+    State start = 0;
+    State firstAccepting = 0;
+    // 0 if the DFA would have needed more than N states
+    std::size_t size = 0;
+    // How many bytes a match may have read past its end, or past the start of
+    // the input when nothing matched
+    std::size_t matchedReach = 0;
+    std::size_t failedReach = 0;
+};
+
+// The states reachable from `states` without reading anything, sorted
+[[nodiscard]] CTPEG_CONSTEXPR std::vector<std::size_t> closure(
+    const Nfa &nfa, std::vector<std::size_t> states) {
+    std::vector<bool> seen(nfa.size());
+    std::vector<std::size_t> out{};
+    while (!states.empty()) {
+        const auto s = states.back();
+        states.pop_back();
+        if (seen[s]) continue;
+        seen[s] = true;
+        out.push_back(s);
+        for (const auto to : nfa.epsilons(s)) {
+            if (!seen[to]) states.push_back(to);
+        }
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+[[nodiscard]] CTPEG_CONSTEXPR std::size_t hash(
+    const std::vector<std::size_t> &values) noexcept {
+    std::size_t h = values.size();
+    for (const auto v : values) h = h * 31 + v;
+    return h;
+}
+
+// Index of `value` in `values`, which are kept along with their hashes. It is
+// added if it is not there yet.
+[[nodiscard]] CTPEG_CONSTEXPR std::size_t intern(
+    std::vector<std::vector<std::size_t>> &values,
+    std::vector<std::size_t> &hashes, std::vector<std::size_t> value) {
+    const auto h = hash(value);
+    for (std::size_t i = 0; i < values.size(); i++) {
+        if (hashes[i] == h && values[i] == value) return i;
+    }
+    values.push_back(std::move(value));
+    hashes.push_back(h);
+    return values.size() - 1;
+}
+
+// Longest run of bytes the DFA may read from `s` without reaching an accepting
+// state, including the byte which stops it
+template <typename State, std::size_t N>
+[[nodiscard]] CTPEG_CONSTEXPR std::size_t lookahead(
+    const Dfa<State, N> &dfa, std::size_t s, std::vector<std::size_t> &memo,
+    std::vector<bool> &visiting) {
+    constexpr auto unknown = std::numeric_limits<std::size_t>::max();
+    if (memo[s] != unknown) return memo[s];
+    // Looping without accepting could read the rest of the input
+    if (visiting[s]) return Dfa<State, N>::Unlimited;
+    visiting[s] = true;
+    std::size_t longest = 0;
+    for (const auto t : dfa.table[s]) {
+        std::size_t len = 1;
+        if (t >= dfa.firstAccepting) {
+            len = 0;
+        } else if (t != 0) {
+            len = std::min(Dfa<State, N>::Unlimited,
+                           1 + lookahead(dfa, t, memo, visiting));
+        }
+        longest = std::max(longest, len);
+    }
+    visiting[s] = false;
+    return memo[s] = longest;
+}
+
+// Turns the NFA into a minimised DFA through the subset construction
+template <typename State, std::size_t N>
+[[nodiscard]] CTPEG_CONSTEXPR Dfa<State, N> compileDfa(const Nfa &nfa,
+                                                       std::size_t start,
+                                                       std::size_t accept) {
+    constexpr auto npos = std::numeric_limits<std::size_t>::max();
+    Dfa<State, N> dfa{};
+
+    // Bytes which no edge tells apart share a class
+    std::array<std::size_t, 256> byteClass{};
+    std::size_t classes = 1;
+    for (std::size_t s = 0; s < nfa.size(); s++) {
+        for (const auto &edge : nfa.edges(s)) {
+            std::vector<std::size_t> in(classes, npos);
+            std::vector<std::size_t> out(classes, npos);
+            std::size_t next = 0;
+            for (std::size_t b = 0; b < 256; b++) {
+                auto &id = contains(edge.set, static_cast<unsigned char>(b))
+                               ? in[byteClass[b]]
+                               : out[byteClass[b]];
+                if (id == npos) id = next++;
+                byteClass[b] = id;
+            }
+            classes = next;
+        }
+    }
+    std::vector<unsigned char> example(classes);
+    for (std::size_t b = 0; b < 256; b++) {
+        example[byteClass[b]] = static_cast<unsigned char>(b);
+    }
+
+    // Subsets of the NFA states, the empty one is the dead state
+    std::vector<std::vector<std::size_t>> subsets{};
+    std::vector<std::size_t> hashes{};
+    static_cast<void>(intern(subsets, hashes, {}));
+    static_cast<void>(intern(subsets, hashes, closure(nfa, {start})));
+    std::vector<std::vector<std::size_t>> moves{};
+    const auto maxSubsets = std::max<std::size_t>(8 * N, 256);
+    for (std::size_t i = 0; i < subsets.size(); i++) {
+        std::vector<std::vector<std::size_t>> next(classes);
+        for (const auto s : subsets[i]) {
+            for (const auto &edge : nfa.edges(s)) {
+                for (std::size_t k = 0; k < classes; k++) {
+                    if (contains(edge.set, example[k])) {
+                        next[k].push_back(edge.to);
+                    }
+                }
+            }
+        }
+        moves.emplace_back(classes);
+        for (std::size_t k = 0; k < classes; k++) {
+            moves[i][k] =
+                intern(subsets, hashes, closure(nfa, std::move(next[k])));
+        }
+        if (subsets.size() > maxSubsets) return dfa;
+    }
+    std::vector<bool> accepting(subsets.size());
+    for (std::size_t i = 0; i < subsets.size(); i++) {
+        accepting[i] = std::binary_search(subsets[i].begin(), subsets[i].end(),
+                                          accept);
+    }
+
+    // Merges the states which accept the same strings
+    std::vector<std::size_t> group(subsets.size());
+    for (std::size_t i = 0; i < subsets.size(); i++) {
+        group[i] = accepting[i] ? 1 : 0;
+    }
+    std::size_t groups = 0;
+    while (true) {
+        std::vector<std::vector<std::size_t>> signatures{};
+        std::vector<std::size_t> signatureHashes{};
+        std::vector<std::size_t> next(subsets.size());
+        for (std::size_t i = 0; i < subsets.size(); i++) {
+            std::vector<std::size_t> signature{group[i]};
+            for (const auto m : moves[i]) signature.push_back(group[m]);
+            next[i] = intern(signatures, signatureHashes, std::move(signature));
+        }
+        group = std::move(next);
+        if (signatures.size() == groups) break;
+        groups = signatures.size();
+    }
+    if (groups > N) return dfa;
+
+    // The dead state comes first and the accepting ones last
+    std::vector<std::size_t> id(groups, npos);
+    std::size_t ids = 0;
+    for (const bool acceptingPass : {false, true}) {
+        if (acceptingPass) dfa.firstAccepting = static_cast<State>(ids);
+        for (std::size_t i = 0; i < subsets.size(); i++) {
+            if (accepting[i] == acceptingPass && id[group[i]] == npos) {
+                id[group[i]] = ids++;
+            }
+        }
+    }
+    if (dfa.firstAccepting == ids) dfa.firstAccepting = static_cast<State>(N);
+    for (std::size_t i = 0; i < subsets.size(); i++) {
+        auto &row = dfa.table[id[group[i]]];
+        for (std::size_t b = 0; b < 256; b++) {
+            row[b] = static_cast<State>(id[group[moves[i][byteClass[b]]]]);
+        }
+    }
+    dfa.start = static_cast<State>(id[group[1]]);
+    dfa.size = groups;
+
+    std::vector<std::size_t> memo(groups, npos);
+    std::vector<bool> visiting(groups);
+    for (std::size_t s = dfa.firstAccepting; s < groups; s++) {
+        dfa.matchedReach =
+            std::max(dfa.matchedReach, lookahead(dfa, s, memo, visiting));
+    }
+    if (dfa.start != 0 && dfa.start < dfa.firstAccepting) {
+        dfa.failedReach = lookahead(dfa, dfa.start, memo, visiting);
+    }
+    return dfa;
+}
+
+// Not constexpr, so that a DFA which does not fit fails to compile
+inline void regularTooLarge() noexcept {}
+
+// The minimised DFA of `arg`, empty if it needs more than N states
+template <typename State, std::size_t N>
+[[nodiscard]] CTPEG_CONSTEXPR Dfa<State, N> compileRegular(const auto &arg) {
+    Nfa nfa{};
+    const auto start = nfa.add();
+    const auto accept = nfa.build(arg, start);
+    auto dfa = compileDfa<State, N>(nfa, start, accept);
+    if (dfa.size == 0) {
+        // "Call to non-constexpr function" when built at compile time: raise
+        // N (or CTPEG_MAX_DFA_STATES)
+        regularTooLarge();
+    }
+    return dfa;
+}
+
+}  // namespace v0_3_1
+}  // namespace ctpeg::detail
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Matches the longest prefix of the input which `arg`, read as a regular
+// expression rather than a PEG, matches. This is how a lexer picks its tokens,
+// and is not always what `arg` matches on its own: a Choice tries every
+// alternative instead of taking the first one which matches, and a repetition
+// gives back what the rest of the sequence needs. E.g. for "int",
+// Choice(String("in"), String("int")) matches "in", but "int" here, and
+// Sequence(Many(Char('a')), Char('a')) only matches here.
+//
+// `pattern` is a lambda without captures which returns `arg`, e.g.
+//   LongestMatch([] { return Choice(String("if"), String("int")); })
+// The input is read with a DFA, one table lookup per byte, and the value is a
+// view of the matched input. The DFA is built once for each pattern, at compile
+// time unless CTPEG_NO_CONSTEXPR is defined, and every copy of the parser
+// shares it. The parser itself is empty, so it costs nothing to nest it in
+// other parsers.
+//
+// N bounds the number of states of the minimised DFA, which takes N * 256
+// bytes (twice that past 255 states).
+template <typename Pattern, std::size_t N>
+struct LongestMatchParser {
+    using value_type = std::string_view;
+    using State = std::conditional_t<(N < 256), std::uint8_t, std::uint16_t>;
+
+    static CTPEG_CONSTEXPR inline const detail::Dfa<State, N> s_dfa =
+        detail::compileRegular<State, N>(Pattern{}());
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(
+        bool matched) const noexcept {
+        return matched ? s_dfa.matchedReach : s_dfa.failedReach;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result
+    operator()(std::string_view arg) const noexcept {
+        return detail::adapt(*this, arg);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    parse(std::string_view arg, std::string_view &out) const noexcept {
+        auto ret = recognize(arg);
+        if (!ret) {
+            CTPEG_TRACE debug::print("LongestMatch: Failed on input \"", arg,
+                                     "\".\n");
+            return ret;
+        }
+        CTPEG_TRACE debug::print(
+            "LongestMatch: Successfully parsed input \"", arg,
+            "\". remaining string to parse: ", ret.value(), ".\n");
+        out = arg.substr(0, arg.size() - ret.value().size());
+        return ret;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view arg) const noexcept {
+        if (s_dfa.size == 0) {
+            return tl::unexpected<Error_t>(Error_t{
+                "LongestMatch: the DFA needs more states than it was given"});
+        }
+        const auto &table = s_dfa.table;
+        const auto firstAccepting = s_dfa.firstAccepting;
+        auto s = s_dfa.start;
+        auto matched = s >= firstAccepting ? std::size_t{0}
+                                           : std::string_view::npos;
+        for (std::size_t i = 0; s != 0 && i < arg.size(); i++) {
+            s = table[s][static_cast<unsigned char>(arg[i])];
+            if (s >= firstAccepting) matched = i + 1;
+        }
+        if (matched == std::string_view::npos) {
+            return tl::unexpected<Error_t>(
+                Error_t{"Failed to parse LongestMatch"});
+        }
+        return arg.substr(matched);
+    }
+};
+
+template <std::size_t N = CTPEG_MAX_DFA_STATES, typename Pattern>
+    requires std::default_initializable<Pattern> &&
+             Parser<std::invoke_result_t<Pattern>>
+[[nodiscard]] CTPEG_CONSTEXPR auto LongestMatch(Pattern) noexcept {
+    static_assert(detail::IsRegular_v<std::invoke_result_t<Pattern>>,
+                  "ctpeg::LongestMatch: the parser may only be built out of "
+                  "Char, CharClass, String, Digit, Bytes, FixedInt, Empty, "
+                  "Choice, Sequence, the repetitions, Maybe, Skip and "
+                  "LongestMatch");
+    return LongestMatchParser<Pattern, N>{};
+}
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+/*
+/////////////////////////////////////
+///////////// Parse trees ///////////
+/////////////////////////////////////
+ */
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// A single node of a parse tree stored in a NodeArena.
+// `begin` and `end` are offsets into the parsed input. Children of the node at
+// index `i` occupy the indices [i + 1, childrenEnd): the first child directly
+// follows its parent, and each sibling directly follows the subtree of the
+// previous one.
+struct Node {
+    std::size_t rule;
+    std::size_t begin;
+    std::size_t end;
+    std::size_t childrenEnd;
+};
+
+// Contiguous pool of nodes produced by Capture. Pass it as the second argument
+// of a parser call to build a tree, e.g. `Final(grammar)(input, arena)`.
+// Calling `reset` keeps the allocated storage, so the same arena can be reused
+// for many parses without allocating per node.
+class NodeArena {
+    std::vector<Node> m_nodes{};
+    std::string_view m_input{};
+
+public:
+    // Clears the arena and sets the input which subsequent parses will see.
+    // Node offsets are computed relative to the start of `input`.
+    CTPEG_CONSTEXPR void reset(std::string_view input) noexcept {
+        m_nodes.clear();
+        m_input = input;
+    }
+
+    CTPEG_CONSTEXPR void reserve(std::size_t n) { m_nodes.reserve(n); }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t mark() const noexcept {
+        return m_nodes.size();
+    }
+
+    CTPEG_CONSTEXPR void rollback(std::size_t m) noexcept {
+        m_nodes.resize(m);
+    }
+
+    // Appends a node starting at `sv`, its children will follow it
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t open(std::size_t rule,
+                                                   std::string_view sv) {
+        const auto offset = this->offset(sv);
+        m_nodes.push_back(Node{rule, offset, offset, m_nodes.size() + 1});
+        return m_nodes.size() - 1;
+    }
+
+    // Appends an already finished node
+    CTPEG_CONSTEXPR void append(Node node) { m_nodes.push_back(node); }
+
+    // Finishes the node opened at `index`, `remaining` is the input left after
+    // it was parsed
+    CTPEG_CONSTEXPR void close(std::size_t index,
+                               std::string_view remaining) noexcept {
+        m_nodes[index].end = offset(remaining);
+        m_nodes[index].childrenEnd = m_nodes.size();
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t size() const noexcept {
+        return m_nodes.size();
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR bool empty() const noexcept {
+        return m_nodes.empty();
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR const Node &operator[](
+        std::size_t i) const noexcept {
+        return m_nodes[i];
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR auto begin() const noexcept {
+        return m_nodes.cbegin();
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR auto end() const noexcept {
+        return m_nodes.cend();
+    }
+
+    // The part of the input spanned by the node, no text is copied
+    [[nodiscard]] CTPEG_CONSTEXPR std::string_view text(
+        const Node &node) const noexcept {
+        return m_input.substr(node.begin, node.end - node.begin);
+    }
+
+    // Calls `fn(index, node)` for every direct child of the node at `parent`
+    CTPEG_CONSTEXPR void forEachChild(std::size_t parent, auto &&fn) const {
+        for (std::size_t i = parent + 1; i < m_nodes[parent].childrenEnd;
+             i = m_nodes[i].childrenEnd) {
+            fn(i, m_nodes[i]);
+        }
+    }
+
+private:
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t offset(
+        std::string_view sv) const noexcept {
+        // `sv` has to be a part of the input given to `reset`
+        assert(sv.data() >= m_input.data() &&
+               sv.data() + sv.size() <= m_input.data() + m_input.size());
+        return static_cast<std::size_t>(sv.data() - m_input.data());
+    }
+};
+
+// Records a node with id `rule` spanning the input consumed by `arg`.
+// Nodes are only recorded when the parser is given a NodeArena, otherwise this
+// behaves exactly like `arg`.
+template <Parser Arg>
+struct CaptureParser {
+    using value_type = ValueOf_t<Arg>;
+
+    std::size_t m_rule;
+    Arg m_arg;
+
+    explicit CTPEG_CONSTEXPR CaptureParser(std::size_t rule, Arg arg)
+        : m_rule(rule), m_arg(arg) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  value_type &out,
+                                                  auto &...ctx) const {
+        return capture(
+            sv, [&] { return detail::parse(m_arg, sv, out, ctx...); },
+            ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    extend(std::string_view sv, ResultVariantArray &out, std::size_t &n,
+           auto &...ctx) const
+        requires std::same_as<value_type, ResultVariantArray>
+    {
+        return capture(
+            sv, [&] { return detail::extend(m_arg, sv, out, n, ctx...); },
+            ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        return detail::recognize(m_arg, sv, ctx...);
+    }
+
+private:
+    // Records the node around `run`, which parses the argument
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining capture(std::string_view sv,
+                                                    const auto &run,
+                                                    auto &...ctx) const {
+        if constexpr (detail::HasContext_v<NodeArena, decltype(ctx)...>) {
+            auto &arena = detail::context<NodeArena>(ctx...);
+            const auto m = arena.mark();
+            const auto index = arena.open(m_rule, sv);
+            auto ret = run();
+            if (ret) {
+                arena.close(index, ret.value());
+                CTPEG_TRACE debug::print(
+                    "Capture(", m_rule, "): Successfully parsed input \"", sv,
+                    "\". remaining string to parse: ", ret.value(), ".\n");
+            } else {
+                arena.rollback(m);
+                CTPEG_TRACE debug::print("Capture(", m_rule,
+                                         "): Failed on input \"", sv, "\".\n");
+            }
+            return ret;
+        } else {
+            return run();
+        }
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Capture(std::size_t rule,
+                                           Parser auto arg) noexcept {
+    return CaptureParser<decltype(arg)>(rule, arg);
+}
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+/*
+/////////////////////////////////////
+/////////// Error recovery //////////
+/////////////////////////////////////
+ */
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Collects the errors Recover skipped over. Pass it as an extra argument of a
+// parser call, e.g. `grammar(input, errors)`. Errors recorded inside branches
+// which were later backtracked out of are discarded.
+class ErrorLog {
+    std::vector<RecoveredError> m_errors{};
+
+public:
+    CTPEG_CONSTEXPR void reset() noexcept { m_errors.clear(); }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t mark() const noexcept {
+        return m_errors.size();
+    }
+
+    CTPEG_CONSTEXPR void rollback(std::size_t m) noexcept {
+        m_errors.erase(
+            std::next(m_errors.begin(), static_cast<std::ptrdiff_t>(m)),
+            m_errors.end());
+    }
+
+    CTPEG_CONSTEXPR void record(RecoveredError err) { m_errors.push_back(err); }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t size() const noexcept {
+        return m_errors.size();
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR bool empty() const noexcept {
+        return m_errors.empty();
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR const RecoveredError &operator[](
+        std::size_t i) const noexcept {
+        return m_errors[i];
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR auto begin() const noexcept {
+        return m_errors.cbegin();
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR auto end() const noexcept {
+        return m_errors.cend();
+    }
+};
+
+// On failure of `arg` skips the input up to and including the first of the
+// characters in `syncSet` (or to the end of input) and succeeds with a
+// RecoveredError, which is also recorded in the ErrorLog if one was given.
+// Fails if there is no input left to skip, so it always makes progress.
+template <Parser Arg>
+struct RecoverParser {
+    using value_type = detail::CommonValue_t<ValueOf_t<Arg>, RecoveredError>;
+
+    Arg m_arg;
+    std::string_view m_syncSet;
+
+    explicit CTPEG_CONSTEXPR RecoverParser(Arg arg, std::string_view syncSet)
+        : m_arg(arg), m_syncSet(syncSet) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  value_type &out,
+                                                  auto &...ctx) const {
+        const auto m = detail::mark(ctx...);
+        auto ret = detail::parseAs(m_arg, sv, out, ctx...);
+        if (ret) {
+            detail::commit(m, ctx...);
+            return ret;
+        }
+        // Nothing recorded by the part of `arg` which did match is kept
+        detail::rollback(m, ctx...);
+        // A fatal error is not a syntax error to recover from
+        if (sv.empty() || detail::isFatal(ret.error())) return ret;
+
+        const auto skipped = sv.substr(0, syncLength(sv));
+        const RecoveredError err{ret.error(), skipped};
+        if constexpr (detail::HasContext_v<ErrorLog, decltype(ctx)...>) {
+            detail::context<ErrorLog>(ctx...).record(err);
+        }
+        CTPEG_TRACE debug::print("Recover: Skipped \"", skipped,
+                                 "\" after error: ", err.error, ".\n");
+        detail::assign(out, err);
+        const Remaining rem{sv.substr(skipped.size())};
+        detail::observe(*this, sv, rem, ctx...);
+        return rem;
+    }
+
+    // Skipping stops at a synchronisation character or the end of input
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t reach(bool) const noexcept {
+        return 1;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        auto ret = detail::recognize(m_arg, sv, ctx...);
+        if (ret || sv.empty() || detail::isFatal(ret.error())) return ret;
+        return sv.substr(syncLength(sv));
+    }
+
+private:
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t syncLength(
+        std::string_view sv) const noexcept {
+        const auto pos = sv.find_first_of(m_syncSet);
+        return pos == std::string_view::npos ? sv.size() : pos + 1;
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Recover(Parser auto arg,
+                                           std::string_view syncSet) noexcept {
+    return RecoverParser<decltype(arg)>(arg, syncSet);
+}
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+/*
+/////////////////////////////////////
+//////// Incremental parsing ////////
+/////////////////////////////////////
+ */
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Remembers the results of Memo parsers by rule and position, along with the
+// range of input each of them examined. After an edit only the entries whose
+// examined range overlaps the edit are dropped, the rest are moved along with
+// the text and reused.
+//
+// Built-in parsers report exactly how far they read. Parsers which do not take
+// contexts and don't have a `reach(bool)` (e.g. plain functions) are assumed to
+// read at most `lookahead` characters past the point they stopped at.
+//
+// Cached values are returned as they were, so values reused across edits should
+// not refer to the input. Use Capture to get spans instead: nodes recorded
+// under a Memo are stored with it and replayed into the NodeArena, the same
+// goes for errors recorded in the ErrorLog.
+class MemoTable {
+public:
+    struct Entry {
+        std::size_t rule;
+        std::size_t begin;
+        std::size_t end;
+        std::size_t examined;
+        ErrorOr<ResultVariant> value;
+        std::size_t nodesBegin;
+        std::size_t nodesEnd;
+        std::size_t errorsBegin;
+        std::size_t errorsEnd;
+        std::size_t next;
+    };
+
+    // How much the NodeArena and ErrorLog held before a parser ran
+    struct Recorded {
+        std::size_t nodes = 0;
+        std::size_t errors = 0;
+    };
+
+private:
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    // A RecoveredError with the skipped input relative to its entry
+    struct StoredError {
+        Error_t error;
+        std::size_t begin;
+        std::size_t size;
+    };
+
+    std::vector<Entry> m_entries{};
+    // Index of the first entry starting at every offset of the input
+    std::vector<std::size_t> m_heads{};
+    // Nodes recorded under entries, offsets are relative to the entry
+    std::vector<Node> m_nodes{};
+    std::vector<StoredError> m_errors{};
+    std::string_view m_input{};
+    std::size_t m_examined = 0;
+    std::size_t m_lookahead;
+
+public:
+    explicit CTPEG_CONSTEXPR MemoTable(std::size_t lookahead = 1)
+        : m_lookahead(lookahead) {}
+
+    // Forgets everything and sets the input which subsequent parses will see
+    CTPEG_CONSTEXPR void reset(std::string_view input) {
+        m_entries.clear();
+        m_nodes.clear();
+        m_errors.clear();
+        m_heads.assign(input.size() + 1, npos);
+        m_input = input;
+        m_examined = 0;
+    }
+
+    // Updates the table after `removed` characters at `offset` were replaced
+    // with `inserted` characters, `input` is the text after the edit
+    CTPEG_CONSTEXPR void edit(std::string_view input, std::size_t offset,
+                              std::size_t removed, std::size_t inserted) {
+        std::vector<Entry> entries{};
+        std::vector<Node> nodes{};
+        std::vector<StoredError> errors{};
+        for (const auto &entry : m_entries) {
+            Entry e = entry;
+            if (entry.examined <= offset) {
+                // Entirely before the edit
+            } else if (entry.begin > offset + removed) {
+                e.begin = e.begin - removed + inserted;
+                e.end = e.end - removed + inserted;
+                e.examined = e.examined - removed + inserted;
+            } else {
+                continue;
+            }
+            e.nodesBegin = nodes.size();
+            const auto from = m_nodes.begin();
+            nodes.insert(
+                nodes.end(),
+                std::next(from, static_cast<std::ptrdiff_t>(entry.nodesBegin)),
+                std::next(from, static_cast<std::ptrdiff_t>(entry.nodesEnd)));
+            e.nodesEnd = nodes.size();
+            e.errorsBegin = errors.size();
+            errors.insert(
+                errors.end(),
+                std::next(m_errors.begin(),
+                          static_cast<std::ptrdiff_t>(entry.errorsBegin)),
+                std::next(m_errors.begin(),
+                          static_cast<std::ptrdiff_t>(entry.errorsEnd)));
+            e.errorsEnd = errors.size();
+            entries.push_back(e);
+        }
+        m_entries = std::move(entries);
+        m_nodes = std::move(nodes);
+        m_errors = std::move(errors);
+        m_input = input;
+        m_examined = 0;
+        m_heads.assign(input.size() + 1, npos);
+        for (std::size_t i = 0; i < m_entries.size(); i++) {
+            m_entries[i].next = m_heads[m_entries[i].begin];
+            m_heads[m_entries[i].begin] = i;
+        }
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t size() const noexcept {
+        return m_entries.size();
+    }
+
+    // Memoised results are valid on every path, nothing is rolled back
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t mark() const noexcept {
+        return 0;
+    }
+
+    CTPEG_CONSTEXPR void rollback(std::size_t) const noexcept {}
+
+    template <typename P>
+    CTPEG_CONSTEXPR void observe(const P &p, std::string_view sv,
+                                 const Remaining &ret) noexcept {
+        std::size_t reach = m_lookahead;
+        if constexpr (requires { p.reach(true); }) {
+            reach = p.reach(ret.has_value());
+        }
+        const auto stop = offset(ret ? ret.value() : sv);
+        m_examined = std::max(m_examined, stop + reach);
+    }
+
+    // Finds the entry for `rule` at `sv`, returns nullptr if there is none
+    [[nodiscard]] CTPEG_CONSTEXPR const Entry *find(
+        std::size_t rule, std::string_view sv) noexcept {
+        for (auto i = m_heads[offset(sv)]; i != npos; i = m_entries[i].next) {
+            if (m_entries[i].rule == rule) {
+                m_examined = std::max(m_examined, m_entries[i].examined);
+                return &m_entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Starts tracking what a parser at `sv` examines, returns the state which
+    // has to be passed to `store` once it has finished
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t enter(
+        std::string_view sv) noexcept {
+        return std::exchange(m_examined, offset(sv));
+    }
+
+    // Remembers the result of `rule` at `sv`, `saved` is what `enter` returned
+    CTPEG_CONSTEXPR void store(std::size_t rule, std::string_view sv,
+                               const Result &ret, std::size_t saved) {
+        const auto begin = offset(sv);
+        const auto end = ret ? offset(ret.value().second) : begin;
+        const auto examined = std::max(m_examined, end);
+        auto value = ret ? ErrorOr<ResultVariant>{ret.value().first}
+                         : ErrorOr<ResultVariant>{
+                               tl::unexpected<Error_t>(ret.error())};
+        m_entries.push_back(Entry{rule, begin, end, examined, value,
+                                  m_nodes.size(), m_nodes.size(),
+                                  m_errors.size(), m_errors.size(),
+                                  m_heads[begin]});
+        m_heads[begin] = m_entries.size() - 1;
+        m_examined = std::max(saved, examined);
+    }
+
+    // Same as above, also keeping the nodes and errors recorded in the
+    // contexts since `before` was taken
+    CTPEG_CONSTEXPR void store(std::size_t rule, std::string_view sv,
+                               const Result &ret, std::size_t saved,
+                               Recorded before, auto &...ctx) {
+        store(rule, sv, ret, saved);
+        if (!ret) return;
+        auto &entry = m_entries.back();
+        if constexpr (detail::HasContext_v<NodeArena, decltype(ctx)...>) {
+            const auto &arena = detail::context<NodeArena>(ctx...);
+            for (auto i = before.nodes; i < arena.size(); i++) {
+                auto node = arena[i];
+                node.begin -= entry.begin;
+                node.end -= entry.begin;
+                node.childrenEnd -= before.nodes;
+                m_nodes.push_back(node);
+            }
+            entry.nodesEnd = m_nodes.size();
+        }
+        if constexpr (detail::HasContext_v<ErrorLog, decltype(ctx)...>) {
+            const auto &log = detail::context<ErrorLog>(ctx...);
+            for (auto i = before.errors; i < log.size(); i++) {
+                const auto begin = offset(log[i].skipped);
+                m_errors.push_back(StoredError{
+                    log[i].error, begin - entry.begin, log[i].skipped.size()});
+            }
+            entry.errorsEnd = m_errors.size();
+        }
+    }
+
+    // What the contexts hold before a parser runs, to be passed to `store`
+    [[nodiscard]] static CTPEG_CONSTEXPR Recorded recorded(
+        auto &...ctx) noexcept {
+        Recorded ret{};
+        if constexpr (detail::HasContext_v<NodeArena, decltype(ctx)...>) {
+            ret.nodes = detail::context<NodeArena>(ctx...).size();
+        }
+        if constexpr (detail::HasContext_v<ErrorLog, decltype(ctx)...>) {
+            ret.errors = detail::context<ErrorLog>(ctx...).size();
+        }
+        return ret;
+    }
+
+    // Rebuilds the result stored in `entry`, and replays its nodes and errors
+    [[nodiscard]] CTPEG_CONSTEXPR Result result(const Entry &entry,
+                                                auto &...ctx) const {
+        if constexpr (detail::HasContext_v<NodeArena, decltype(ctx)...>) {
+            auto &arena = detail::context<NodeArena>(ctx...);
+            const auto first = arena.size();
+            for (auto i = entry.nodesBegin; i < entry.nodesEnd; i++) {
+                auto node = m_nodes[i];
+                node.begin += entry.begin;
+                node.end += entry.begin;
+                node.childrenEnd += first;
+                arena.append(node);
+            }
+        }
+        if constexpr (detail::HasContext_v<ErrorLog, decltype(ctx)...>) {
+            auto &log = detail::context<ErrorLog>(ctx...);
+            for (auto i = entry.errorsBegin; i < entry.errorsEnd; i++) {
+                const auto &err = m_errors[i];
+                log.record(RecoveredError{
+                    err.error, m_input.substr(entry.begin + err.begin,
+                                              err.size)});
+            }
+        }
+        if (entry.value) {
+            return std::make_pair(entry.value.value(),
+                                  m_input.substr(entry.end));
+        }
+        return tl::unexpected<Error_t>(entry.value.error());
+    }
+
+private:
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t offset(
+        std::string_view sv) const noexcept {
+        return static_cast<std::size_t>(sv.data() - m_input.data());
+    }
+};
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+namespace ctpeg::detail {
+inline namespace v0_3_1 {
+
+// Whether T is an EventSink, specialised along with it
+template <typename T>
+constexpr bool IsEventSink_v = false;
+
+}  // namespace v0_3_1
+}  // namespace ctpeg::detail
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Memoises `arg` under the id `rule` when given a MemoTable, otherwise this
+// behaves exactly like `arg`. Every Memo in a grammar needs its own id.
+//
+// Events are not stored in the table, so when an EventSink is given as well
+// the table is not used and `arg` always runs.
+template <Parser Arg>
+struct MemoParser {
+    std::size_t m_rule;
+    Arg m_arg;
+
+    explicit CTPEG_CONSTEXPR MemoParser(std::size_t rule, Arg arg)
+        : m_rule(rule), m_arg(arg) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        constexpr bool events =
+            (detail::IsEventSink_v<std::remove_cvref_t<decltype(ctx)>> ||
+             ...);
+        if constexpr (detail::HasContext_v<MemoTable, decltype(ctx)...> &&
+                      !events) {
+            auto &table = detail::context<MemoTable>(ctx...);
+            if (const auto *entry = table.find(m_rule, sv)) {
+                CTPEG_TRACE debug::print("Memo(", m_rule,
+                                         "): Reused result for input \"", sv,
+                                         "\".\n");
+                return table.result(*entry, ctx...);
+            }
+            const auto saved = table.enter(sv);
+            const auto before = MemoTable::recorded(ctx...);
+            auto ret = detail::call(m_arg, sv, ctx...);
+            table.store(m_rule, sv, ret, saved, before, ctx...);
+            return ret;
+        } else {
+            return detail::call(m_arg, sv, ctx...);
+        }
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        return detail::recognize(m_arg, sv, ctx...);
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Memo(std::size_t rule,
+                                        Parser auto arg) noexcept {
+    return MemoParser<decltype(arg)>(rule, arg);
+}
+
+// Owns a document and reparses it after edits, reusing everything the edit
+// did not affect. Wrap the rules worth reusing in Memo.
+template <Parser P>
+class Incremental {
+    P m_parser;
+    std::string m_text{};
+    MemoTable m_memo;
+
+public:
+    explicit CTPEG_CONSTEXPR Incremental(P parser, std::size_t lookahead = 1)
+        : m_parser(parser), m_memo(lookahead) {}
+
+    // Replaces the whole document, nothing is reused by the next parse
+    CTPEG_CONSTEXPR void assign(std::string_view text) {
+        m_text = text;
+        m_memo.reset(m_text);
+    }
+
+    // Replaces `removed` characters at `offset` with `inserted`
+    CTPEG_CONSTEXPR void edit(std::size_t offset, std::size_t removed,
+                              std::string_view inserted) {
+        m_text.replace(offset, removed, inserted);
+        m_memo.edit(m_text, offset, removed, inserted.size());
+    }
+
+    // Parses the current document. Other contexts, e.g. a NodeArena reset with
+    // `text()`, may be passed along.
+    [[nodiscard]] CTPEG_CONSTEXPR Result parse(auto &...ctx) {
+        return detail::call(m_parser, m_text, m_memo, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::string_view text() const noexcept {
+        return m_text;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR const MemoTable &memo() const noexcept {
+        return m_memo;
+    }
+};
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+/*
+/////////////////////////////////////
+/////////// Event streams ///////////
+/////////////////////////////////////
+ */
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Forwards the events of Report parsers to a user defined sink, which gets
+// them through whichever of these members it has:
+//   begin(std::size_t rule, std::size_t offset)
+//   value(std::size_t rule, const T &value)
+//   end(std::size_t rule, std::size_t begin, std::size_t end)
+// Offsets are relative to the input given to `reset`. `value` is called with
+// the value the rule produced (char, int64_t, ...), arrays and EmptyVariant are
+// not reported.
+//
+// While a parser which could backtrack over them (e.g. an alternative of a
+// Choice) is still running, events are held back. They are dropped if it
+// fails, and sent as soon as nothing can undo them any more. If the whole parse
+// fails, the events before the point of failure have already been sent.
+template <typename Sink>
+class EventSink {
+    enum class Kind { Begin, Value, End };
+
+    struct Event {
+        Kind kind;
+        std::size_t rule;
+        std::size_t begin;
+        std::size_t end;
+        ResultVariantSingle value;
+    };
+
+    Sink &m_sink;
+    std::vector<Event> m_events{};
+    std::size_t m_depth = 0;
+    std::string_view m_input{};
+
+public:
+    explicit CTPEG_CONSTEXPR EventSink(Sink &sink) : m_sink(sink) {}
+
+    // Sets the input which subsequent parses will see, and drops the events
+    // which were still held back
+    CTPEG_CONSTEXPR void reset(std::string_view input) noexcept {
+        m_events.clear();
+        m_depth = 0;
+        m_input = input;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t mark() noexcept {
+        m_depth++;
+        return m_events.size();
+    }
+
+    CTPEG_CONSTEXPR void rollback(std::size_t m) noexcept {
+        m_depth--;
+        m_events.erase(
+            std::next(m_events.begin(), static_cast<std::ptrdiff_t>(m)),
+            m_events.end());
+    }
+
+    CTPEG_CONSTEXPR void commit(std::size_t) {
+        if (--m_depth == 0) {
+            for (const auto &event : m_events) send(event);
+            m_events.clear();
+        }
+    }
+
+    CTPEG_CONSTEXPR void begin(std::size_t rule, std::string_view sv) {
+        record(Event{Kind::Begin, rule, offset(sv), offset(sv), {}});
+    }
+
+    template <typename T>
+    CTPEG_CONSTEXPR void value(std::size_t rule, const T &value) {
+        if constexpr (std::same_as<T, ResultVariant> ||
+                      std::same_as<T, ResultVariantSingle>) {
+            std::visit([&](const auto &v) { this->value(rule, v); }, value);
+        } else if constexpr (!std::same_as<T, ResultVariantArray> &&
+                             !std::same_as<T, EmptyVariant> &&
+                             !std::same_as<T, UninitialisedVariant>) {
+            record(Event{Kind::Value, rule, 0, 0, ResultVariantSingle{value}});
+        }
+    }
+
+    // `sv` is the input the rule started at, `remaining` what it left
+    CTPEG_CONSTEXPR void end(std::size_t rule, std::string_view sv,
+                             std::string_view remaining) {
+        record(Event{Kind::End, rule, offset(sv), offset(remaining), {}});
+    }
+
+private:
+    CTPEG_CONSTEXPR void record(const Event &event) {
+        if (m_depth == 0) {
+            send(event);
+        } else {
+            m_events.push_back(event);
+        }
+    }
+
+    CTPEG_CONSTEXPR void send(const Event &event) {
+        switch (event.kind) {
+            case Kind::Begin:
+                if constexpr (requires { m_sink.begin(event.rule, 0); }) {
+                    m_sink.begin(event.rule, event.begin);
+                }
+                break;
+            case Kind::Value:
+                std::visit(
+                    [&](const auto &v) {
+                        if constexpr (requires {
+                                          m_sink.value(event.rule, v);
+                                      }) {
+                            m_sink.value(event.rule, v);
+                        }
+                    },
+                    event.value);
+                break;
+            case Kind::End:
+                if constexpr (requires { m_sink.end(event.rule, 0, 0); }) {
+                    m_sink.end(event.rule, event.begin, event.end);
+                }
+                break;
+        }
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t offset(
+        std::string_view sv) const noexcept {
+        return static_cast<std::size_t>(sv.data() - m_input.data());
+    }
+};
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+namespace ctpeg::detail {
+inline namespace v0_3_1 {
+
+template <typename Sink>
+constexpr bool IsEventSink_v<EventSink<Sink>> = true;
+
+// Calls `fn` with every EventSink out of the contexts
+template <typename... Ctx>
+CTPEG_CONSTEXPR void forEachEventSink(const auto &fn, Ctx &...ctx) {
+    (
+        [&](auto &c) {
+            if constexpr (IsEventSink_v<std::remove_cvref_t<decltype(c)>>) {
+                fn(c);
+            }
+        }(ctx),
+        ...);
+}
+
+}  // namespace v0_3_1
+}  // namespace ctpeg::detail
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Sends begin, value and end events for `rule` to the EventSink, if one was
+// given. Otherwise this behaves exactly like `arg`.
+template <Parser Arg>
+struct ReportParser {
+    using value_type = ValueOf_t<Arg>;
+
+    std::size_t m_rule;
+    Arg m_arg;
+
+    explicit CTPEG_CONSTEXPR ReportParser(std::size_t rule, Arg arg)
+        : m_rule(rule), m_arg(arg) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  value_type &out,
+                                                  auto &...ctx) const {
+        detail::forEachEventSink(
+            [&](auto &events) { events.begin(m_rule, sv); }, ctx...);
+        auto ret = detail::parse(m_arg, sv, out, ctx...);
+        if (ret) {
+            detail::forEachEventSink(
+                [&](auto &events) {
+                    events.value(m_rule, out);
+                    events.end(m_rule, sv, ret.value());
+                },
+                ctx...);
+        }
+        return ret;
+    }
+
+    // Values which are arrays are not reported, so they can be appended to
+    // the enclosing array directly
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    extend(std::string_view sv, ResultVariantArray &out, std::size_t &n,
+           auto &...ctx) const
+        requires std::same_as<value_type, ResultVariantArray>
+    {
+        detail::forEachEventSink(
+            [&](auto &events) { events.begin(m_rule, sv); }, ctx...);
+        auto ret = detail::extend(m_arg, sv, out, n, ctx...);
+        if (ret) {
+            detail::forEachEventSink(
+                [&](auto &events) { events.end(m_rule, sv, ret.value()); },
+                ctx...);
+        }
+        return ret;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        return detail::recognize(m_arg, sv, ctx...);
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Report(std::size_t rule,
+                                          Parser auto arg) noexcept {
+    return ReportParser<decltype(arg)>(rule, arg);
+}
+
+// Parses `input` and streams the events of the Report parsers in `parser` to
+// `sink`, no values are handed back. Other contexts may be passed along.
+template <typename Sink>
+[[nodiscard]] CTPEG_CONSTEXPR Remaining parseEvents(const Parser auto &parser,
+                                                    std::string_view input,
+                                                    Sink &sink, auto &...ctx) {
+    EventSink<Sink> events(sink);
+    events.reset(input);
+    ValueOf_t<std::remove_cvref_t<decltype(parser)>> value{};
+    return detail::parse(parser, input, value, events, ctx...);
+}
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+/*
+/////////////////////////////////////
+/////////// Nesting limits //////////
+/////////////////////////////////////
+ */
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Bounds how deeply Nest parsers and recursive grammar rules may be entered
+// within each other, so that input nested arbitrarily deep fails instead of
+// running out of stack. Pass it as an extra argument of a parser call, e.g.
+// `grammar(input, limit)`, or as the second argument of a Recognize. The Nest
+// which would go over the limit fails with TooDeep. Choice, Repeat, Recover
+// and Not pass that error on instead of trying something else, so the whole
+// parse fails with TooDeep. The limit stays exceeded until `reset`.
+//
+// Only parsers which get the contexts are bounded. Recursion through plain
+// functions, such as ExprParser in the example, is not bounded unless the
+// recursive call goes through a Nest which is given the contexts. A user
+// defined parser may also turn TooDeep into another error, `exceeded` (or
+// parseValue, which checks it) tells whether the limit was hit.
+class DepthLimit {
+    std::size_t m_limit;
+    std::size_t m_depth = 0;
+    bool m_exceeded = false;
+
+public:
+    explicit CTPEG_CONSTEXPR DepthLimit(std::size_t limit) noexcept
+        : m_limit(limit) {}
+
+    CTPEG_CONSTEXPR void reset() noexcept {
+        m_depth = 0;
+        m_exceeded = false;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t mark() const noexcept {
+        return m_depth;
+    }
+
+    CTPEG_CONSTEXPR void rollback(std::size_t m) noexcept { m_depth = m; }
+
+    // Returns false, and fails the rest of the parse, if entering another level
+    // would go over the limit
+    [[nodiscard]] CTPEG_CONSTEXPR bool enter() noexcept {
+        if (m_exceeded || m_depth == m_limit) {
+            m_exceeded = true;
+            return false;
+        }
+        m_depth++;
+        return true;
+    }
+
+    CTPEG_CONSTEXPR void leave() noexcept { m_depth--; }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t depth() const noexcept {
+        return m_depth;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR std::size_t limit() const noexcept {
+        return m_limit;
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR bool exceeded() const noexcept {
+        return m_exceeded;
+    }
+};
+
+// Counts as one level of nesting against the DepthLimit, if one was given.
+// Otherwise this behaves exactly like `arg`. Wrap the recursive references of
+// user defined rules in it, recursive grammar rules already are.
+template <Parser Arg>
+struct NestParser {
+    using value_type = ValueOf_t<Arg>;
+
+    Arg m_arg;
+
+    explicit CTPEG_CONSTEXPR NestParser(Arg arg) : m_arg(arg) {}
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return detail::adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  value_type &out,
+                                                  auto &...ctx) const {
+        return nest(
+            sv, [&] { return detail::parse(m_arg, sv, out, ctx...); },
+            ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    extend(std::string_view sv, ResultVariantArray &out, std::size_t &n,
+           auto &...ctx) const {
+        return nest(
+            sv, [&] { return detail::extend(m_arg, sv, out, n, ctx...); },
+            ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        return nest(
+            sv, [&] { return detail::recognize(m_arg, sv, ctx...); }, ctx...);
+    }
+
+private:
+    // Runs `run`, which parses the argument, one level deeper
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining nest(std::string_view sv,
+                                                 const auto &run,
+                                                 auto &...ctx) const {
+        if constexpr (detail::HasContext_v<DepthLimit, decltype(ctx)...>) {
+            auto &limit = detail::context<DepthLimit>(ctx...);
+            if (!limit.enter()) {
+                CTPEG_TRACE debug::print("Nest: Failed on input \"", sv,
+                                         "\". Nested deeper than ",
+                                         limit.limit(), " levels\n");
+                return tl::unexpected<Error_t>(TooDeep);
+            }
+            auto ret = run();
+            limit.leave();
+            return ret;
+        } else {
+            return run();
+        }
+    }
+};
+
+[[nodiscard]] CTPEG_CONSTEXPR auto Nest(Parser auto arg) noexcept {
+    return NestParser<decltype(arg)>(arg);
+}
+
+template <Parser Arg>
+CTPEG_CONSTEXPR ErrorOr<std::size_t> Recognizer<Arg>::operator()(
+    std::string_view sv, DepthLimit &limit) const noexcept {
+    auto ret = detail::recognize(m_arg, sv, limit);
+    if (limit.exceeded()) return tl::unexpected<Error_t>(TooDeep);
+    if (!ret) return tl::unexpected<Error_t>(ret.error());
+    return sv.size() - ret.value().size();
+}
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+/*
+/////////////////////////////////////
+/////////// Values //////////////////
+/////////////////////////////////////
+ */
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Parses `input` and hands back the value of `parser` as a T. Parsers whose
+// value is a variant fail if it does not hold a T. Input left over after the
+// parser is ignored. Contexts are passed along to the parser, if a DepthLimit
+// was exceeded the parse fails with TooDeep.
+template <typename T>
+[[nodiscard]] CTPEG_CONSTEXPR ErrorOr<T> parseValue(const Parser auto &parser,
+                                                    std::string_view input,
+                                                    auto &...ctx) {
+    using Value = ValueOf_t<std::remove_cvref_t<decltype(parser)>>;
+    Value value{};
+    auto ret = detail::parse(parser, input, value, ctx...);
+    if constexpr (detail::HasContext_v<DepthLimit, decltype(ctx)...>) {
+        if (detail::context<DepthLimit>(ctx...).exceeded()) {
+            return tl::unexpected<Error_t>(TooDeep);
+        }
+    }
+    if (!ret) return tl::unexpected<Error_t>(ret.error());
+    if constexpr (std::same_as<T, Value>) {
+        return value;
+    } else {
+        if (!std::holds_alternative<T>(value)) {
+            return tl::unexpected<Error_t>(Error_t{
+                "Parser did not produce a value of the requested type"});
+        }
+        return std::get<T>(value);
+    }
+}
+
+}  // namespace v0_3_1
+}  // namespace ctpeg
+
+/*
+/////////////////////////////////////
+/////////// Grammar strings /////////
+/////////////////////////////////////
+ */
+
+namespace ctpeg::detail {
+inline namespace v0_3_1 {
+
+template <std::size_t N>
+struct FixedString {
+    char m_data[N]{};
+
+    // Implicit, so that string literals can be used as template arguments
+    constexpr FixedString(const char (&str)[N]) noexcept {
+        std::copy_n(str, N, m_data);
+    }
+
+    [[nodiscard]] constexpr std::string_view view() const noexcept {
+        return {m_data, N - 1};
+    }
+};
+
+enum class GrammarOp {
+    Choice,
+    Sequence,
+    Empty,
+    And,
+    Not,
+    Maybe,
+    Many,
+    Many1,
+    Literal,
+    Class,
+    Any,
+    Rule,
+};
+
+struct GrammarNode {
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    GrammarOp op = GrammarOp::Empty;
+    // Children of Choice, Sequence and the prefix and suffix operators
+    std::size_t first = npos;
+    std::size_t next = npos;
+    std::size_t count = 0;
+    // Literal text, or the name of the Rule before it is resolved
+    std::size_t begin = 0;
+    std::size_t length = 0;
+    std::size_t rule = 0;
+    std::array<std::uint64_t, 4> set{};
+};
+
+struct GrammarRule {
+    std::size_t nameBegin = 0;
+    std::size_t nameLength = 0;
+    std::size_t expr = 0;
+    bool recursive = false;
+};
+
+// Grammar read out of the text of a grammar. N bounds the number of nodes,
+// rules and literal characters.
+template <std::size_t N>
+struct GrammarAst {
+    std::array<GrammarNode, N> nodes{};
+    std::size_t nodeCount = 0;
+    std::array<GrammarRule, N> rules{};
+    std::size_t ruleCount = 0;
+    std::array<char, N> text{};
+    std::size_t textLength = 0;
+    std::string_view error{};
+    std::size_t errorPosition = 0;
+};
+
+// Recursive descent reader for the PEG notation:
+//   Grammar    <- Spacing Definition+ EndOfFile
+//   Definition <- Identifier '<-' Expression
+//   Expression <- Sequence ('/' Sequence)*
+//   Sequence   <- Prefix*
+//   Prefix     <- ('&' / '!')? Suffix
+//   Suffix     <- Primary ('?' / '*' / '+')?
+//   Primary    <- Identifier !'<-' / '(' Expression ')' / Literal / Class / '.'
+// Literals are quoted with ' or ", classes may be negated with [^...], and
+// comments start with # and run to the end of the line.
+template <std::size_t N>
+class GrammarReader {
+    static constexpr std::size_t npos = GrammarNode::npos;
+
+    std::string_view m_src;
+    std::size_t m_pos = 0;
+    GrammarAst<N> m_ast{};
+
+public:
+    explicit constexpr GrammarReader(std::string_view src) noexcept
+        : m_src(src) {}
+
+    [[nodiscard]] constexpr GrammarAst<N> read() noexcept {
+        spacing();
+        while (m_pos < m_src.size() && !failed()) definition();
+        if (!failed() && m_ast.ruleCount == 0) fail("Grammar has no rules");
+        if (!failed()) resolve();
+        return m_ast;
+    }
+
+private:
+    [[nodiscard]] constexpr bool failed() const noexcept {
+        return !m_ast.error.empty();
+    }
+
+    constexpr std::size_t fail(std::string_view error) noexcept {
+        if (!failed()) {
+            m_ast.error = error;
+            m_ast.errorPosition = m_pos;
+        }
+        return npos;
+    }
+
+    [[nodiscard]] constexpr bool at(char c) const noexcept {
+        return m_pos < m_src.size() && m_src[m_pos] == c;
+    }
+
+    [[nodiscard]] constexpr bool at(std::string_view sv) const noexcept {
+        return m_src.substr(m_pos).starts_with(sv);
+    }
+
+    constexpr bool eat(std::string_view sv) noexcept {
+        if (!at(sv)) return false;
+        m_pos += sv.size();
+        spacing();
+        return true;
+    }
+
+    constexpr void spacing() noexcept {
+        while (m_pos < m_src.size()) {
+            if (at(' ') || at('\t') || at('\r') || at('\n')) {
+                m_pos++;
+            } else if (at('#')) {
+                while (m_pos < m_src.size() && !at('\n')) m_pos++;
+            } else {
+                break;
+            }
+        }
+    }
+
+    [[nodiscard]] static constexpr bool isIdentStart(char c) noexcept {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    [[nodiscard]] static constexpr bool isIdentChar(char c) noexcept {
+        return isIdentStart(c) || isdigit(c);
+    }
+
+    // Reads an identifier without the spacing after it, returns its length
+    constexpr std::size_t identifier() noexcept {
+        const auto begin = m_pos;
+        if (m_pos < m_src.size() && isIdentStart(m_src[m_pos])) {
+            while (m_pos < m_src.size() && isIdentChar(m_src[m_pos])) m_pos++;
+        }
+        return m_pos - begin;
+    }
+
+    // Whether the input is at the start of the next definition
+    [[nodiscard]] constexpr bool atDefinition() noexcept {
+        const auto pos = m_pos;
+        const bool found = identifier() != 0 && (spacing(), at("<-"));
+        m_pos = pos;
+        return found;
+    }
+
+    constexpr std::size_t node(GrammarNode n) noexcept {
+        if (m_ast.nodeCount == N) return fail("Grammar is too large");
+        m_ast.nodes[m_ast.nodeCount] = n;
+        return m_ast.nodeCount++;
+    }
+
+    // Makes a node of `op` with the children chained from `first`, or returns
+    // the only child if there is just one
+    constexpr std::size_t list(GrammarOp op, std::size_t first,
+                               std::size_t count) noexcept {
+        if (count == 1) return first;
+        GrammarNode n{};
+        n.op = count == 0 ? GrammarOp::Empty : op;
+        n.first = first;
+        n.count = count;
+        return node(n);
+    }
+
+    constexpr void definition() noexcept {
+        const auto nameBegin = m_pos;
+        const auto nameLength = identifier();
+        if (nameLength == 0) {
+            fail("Expected a rule name");
+            return;
+        }
+        spacing();
+        if (!eat("<-")) {
+            fail("Expected '<-' after the rule name");
+            return;
+        }
+        for (std::size_t r = 0; r < m_ast.ruleCount; r++) {
+            const auto &other = m_ast.rules[r];
+            if (name(other.nameBegin, other.nameLength) ==
+                name(nameBegin, nameLength)) {
+                m_pos = nameBegin;
+                fail("Rule is defined more than once");
+                return;
+            }
+        }
+        if (m_ast.ruleCount == N) {
+            fail("Grammar is too large");
+            return;
+        }
+        const auto rule = m_ast.ruleCount++;
+        m_ast.rules[rule] = GrammarRule{nameBegin, nameLength, 0, false};
+        m_ast.rules[rule].expr = expression();
+    }
+
+    constexpr std::size_t expression() noexcept {
+        const auto first = sequence();
+        std::size_t count = 1;
+        for (auto last = first; !failed() && eat("/"); count++) {
+            const auto alt = sequence();
+            if (failed()) break;
+            m_ast.nodes[last].next = alt;
+            last = alt;
+        }
+        if (failed()) return npos;
+        return list(GrammarOp::Choice, first, count);
+    }
+
+    constexpr std::size_t sequence() noexcept {
+        std::size_t first = npos;
+        std::size_t last = npos;
+        std::size_t count = 0;
+        while (!failed() && m_pos < m_src.size() && !at('/') && !at(')') &&
+               !atDefinition()) {
+            const auto elem = prefix();
+            if (failed()) return npos;
+            if (count++ == 0) {
+                first = elem;
+            } else {
+                m_ast.nodes[last].next = elem;
+            }
+            last = elem;
+        }
+        return list(GrammarOp::Sequence, first, count);
+    }
+
+    constexpr std::size_t unary(GrammarOp op, std::size_t child) noexcept {
+        if (failed()) return npos;
+        GrammarNode n{};
+        n.op = op;
+        n.first = child;
+        n.count = 1;
+        return node(n);
+    }
+
+    constexpr std::size_t prefix() noexcept {
+        if (eat("&")) return unary(GrammarOp::And, suffix());
+        if (eat("!")) return unary(GrammarOp::Not, suffix());
+        return suffix();
+    }
+
+    constexpr std::size_t suffix() noexcept {
+        const auto p = primary();
+        if (eat("?")) return unary(GrammarOp::Maybe, p);
+        if (eat("*")) return unary(GrammarOp::Many, p);
+        if (eat("+")) return unary(GrammarOp::Many1, p);
+        return p;
+    }
+
+    constexpr std::size_t primary() noexcept {
+        GrammarNode n{};
+        if (eat("(")) {
+            const auto e = expression();
+            if (!failed() && !eat(")")) return fail("Expected ')'");
+            return e;
+        }
+        if (eat(".")) {
+            n.op = GrammarOp::Any;
+            return node(n);
+        }
+        if (at('\'') || at('"')) return literal();
+        if (at('[')) return charClass();
+        n.begin = m_pos;
+        n.length = identifier();
+        if (n.length == 0) return fail("Expected an expression");
+        n.op = GrammarOp::Rule;
+        spacing();
+        return node(n);
+    }
+
+    // Reads one possibly escaped character of a literal or a class
+    constexpr char character() noexcept {
+        auto c = m_src[m_pos++];
+        if (c != '\\' || m_pos == m_src.size()) return c;
+        c = m_src[m_pos++];
+        switch (c) {
+            case 'n':
+                return '\n';
+            case 'r':
+                return '\r';
+            case 't':
+                return '\t';
+            case '0':
+                return '\0';
+            default:
+                return c;
+        }
+    }
+
+    constexpr std::size_t literal() noexcept {
+        const auto quote = m_src[m_pos++];
+        GrammarNode n{};
+        n.op = GrammarOp::Literal;
+        n.begin = m_ast.textLength;
+        while (m_pos < m_src.size() && !at(quote)) {
+            if (m_ast.textLength == N) return fail("Grammar is too large");
+            m_ast.text[m_ast.textLength++] = character();
+        }
+        if (!eat(std::string_view{&quote, 1})) {
+            return fail("Unterminated literal");
+        }
+        n.length = m_ast.textLength - n.begin;
+        return node(n);
+    }
+
+    constexpr std::size_t charClass() noexcept {
+        m_pos++;
+        GrammarNode n{};
+        n.op = GrammarOp::Class;
+        const bool negated = at('^');
+        if (negated) m_pos++;
+        while (m_pos < m_src.size() && !at(']')) {
+            const auto first = static_cast<unsigned char>(character());
+            auto last = first;
+            if (at('-') && m_pos + 1 < m_src.size() &&
+                m_src[m_pos + 1] != ']') {
+                m_pos++;
+                last = static_cast<unsigned char>(character());
+            }
+            for (unsigned c = first; c <= last; c++) {
+                n.set[c >> 6] |= std::uint64_t{1} << (c & 63);
+            }
+        }
+        if (!eat("]")) return fail("Unterminated character class");
+        if (negated) {
+            for (auto &word : n.set) word = ~word;
+        }
+        return node(n);
+    }
+
+    [[nodiscard]] constexpr std::string_view name(std::size_t begin,
+                                                  std::size_t length) const {
+        return m_src.substr(begin, length);
+    }
+
+    // Points rule references at their rules, finds recursive rules and
+    // rejects left recursive ones
+    constexpr void resolve() noexcept {
+        for (std::size_t i = 0; i < m_ast.nodeCount; i++) {
+            auto &n = m_ast.nodes[i];
+            if (n.op != GrammarOp::Rule) continue;
+            n.rule = npos;
+            for (std::size_t r = 0; r < m_ast.ruleCount; r++) {
+                const auto &rule = m_ast.rules[r];
+                if (name(rule.nameBegin, rule.nameLength) ==
+                    name(n.begin, n.length)) {
+                    n.rule = r;
+                }
+            }
+            if (n.rule == npos) {
+                m_pos = n.begin;
+                fail("Reference to an undefined rule");
+                return;
+            }
+        }
+        for (std::size_t r = 0; r < m_ast.ruleCount; r++) {
+            std::array<bool, N> visited{};
+            m_ast.rules[r].recursive =
+                reaches(m_ast.rules[r].expr, r, visited);
+        }
+
+        // Which rules can match without consuming input, until nothing changes
+        std::array<bool, N> nullable{};
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (std::size_t r = 0; r < m_ast.ruleCount; r++) {
+                if (!nullable[r] && isNullable(m_ast.rules[r].expr, nullable)) {
+                    nullable[r] = changed = true;
+                }
+            }
+        }
+        for (std::size_t r = 0; r < m_ast.ruleCount; r++) {
+            if (!m_ast.rules[r].recursive) continue;
+            std::array<bool, N> visited{};
+            if (reachesFirst(m_ast.rules[r].expr, r, nullable, visited)) {
+                m_pos = m_ast.rules[r].nameBegin;
+                fail("Rule is left recursive");
+                return;
+            }
+        }
+    }
+
+    // Whether the expression at `i` can match without consuming input, given
+    // which rules can
+    [[nodiscard]] constexpr bool isNullable(
+        std::size_t i, const std::array<bool, N> &nullable) const noexcept {
+        const auto &n = m_ast.nodes[i];
+        switch (n.op) {
+            case GrammarOp::Choice:
+                for (auto c = n.first; c != npos; c = m_ast.nodes[c].next) {
+                    if (isNullable(c, nullable)) return true;
+                }
+                return false;
+            case GrammarOp::Sequence:
+                for (auto c = n.first; c != npos; c = m_ast.nodes[c].next) {
+                    if (!isNullable(c, nullable)) return false;
+                }
+                return true;
+            case GrammarOp::Many1:
+                return isNullable(n.first, nullable);
+            case GrammarOp::Literal:
+                return n.length == 0;
+            case GrammarOp::Class:
+            case GrammarOp::Any:
+                return false;
+            case GrammarOp::Rule:
+                return nullable[n.rule];
+            default:
+                return true;
+        }
+    }
+
+    // Whether the expression at `i` can refer back to `rule` before it has
+    // consumed any input
+    [[nodiscard]] constexpr bool reachesFirst(
+        std::size_t i, std::size_t rule, const std::array<bool, N> &nullable,
+        std::array<bool, N> &visited) const noexcept {
+        const auto &n = m_ast.nodes[i];
+        if (n.op == GrammarOp::Rule) {
+            if (n.rule == rule) return true;
+            if (visited[n.rule]) return false;
+            visited[n.rule] = true;
+            return reachesFirst(m_ast.rules[n.rule].expr, rule, nullable,
+                                visited);
+        }
+        for (auto c = n.first; c != npos; c = m_ast.nodes[c].next) {
+            if (reachesFirst(c, rule, nullable, visited)) return true;
+            if (n.count == 1) break;
+            // Later elements of a sequence only start where this one stopped
+            if (n.op == GrammarOp::Sequence && !isNullable(c, nullable)) break;
+        }
+        return false;
+    }
+
+    // Whether the expression at `i` can refer back to `rule`
+    [[nodiscard]] constexpr bool reaches(std::size_t i, std::size_t rule,
+                                         std::array<bool, N> &visited) const {
+        const auto &n = m_ast.nodes[i];
+        if (n.op == GrammarOp::Rule) {
+            if (n.rule == rule) return true;
+            if (visited[n.rule]) return false;
+            visited[n.rule] = true;
+            return reaches(m_ast.rules[n.rule].expr, rule, visited);
+        }
+        for (auto c = n.first; c != npos; c = m_ast.nodes[c].next) {
+            if (reaches(c, rule, visited)) return true;
+            if (n.count == 1) break;
+        }
+        return false;
+    }
+};
+
+template <FixedString G>
+inline constexpr auto grammarAst =
+    GrammarReader<2 * sizeof(G.m_data) + 8>(G.view()).read();
+
+// Index of the `n`th child of node `i`
+template <FixedString G>
+[[nodiscard]] constexpr std::size_t grammarChild(std::size_t i,
+                                                 std::size_t n) noexcept {
+    auto c = grammarAst<G>.nodes[i].first;
+    while (n--) c = grammarAst<G>.nodes[c].next;
+    return c;
+}
+
+template <FixedString G, std::size_t I>
+[[nodiscard]] CTPEG_CONSTEXPR auto lowerGrammar() noexcept;
+
+// Stands in for a recursive rule, so that the type of the parser is finite.
+// Every reference counts as a level of nesting against a DepthLimit.
+template <FixedString G, std::size_t R>
+struct GrammarRuleRef {
+    // Can not depend on the rule, which may contain this very reference
+    using value_type = ResultVariant;
+
+    [[nodiscard]] CTPEG_CONSTEXPR Result operator()(std::string_view sv,
+                                                    auto &...ctx) const {
+        return adapt(*this, sv, ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining parse(std::string_view sv,
+                                                  ResultVariant &out,
+                                                  auto &...ctx) const {
+        return parseAs(Nest(lowerGrammar<G, grammarAst<G>.rules[R].expr>()),
+                       sv, out, ctx...);
+    }
+
+    // Appends to the enclosing array directly, so that a level of recursion
+    // does not hold a whole ResultVariant on the stack
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining extend(std::string_view sv,
+                                                   ResultVariantArray &out,
+                                                   std::size_t &n,
+                                                   auto &...ctx) const {
+        return detail::extend(
+            Nest(lowerGrammar<G, grammarAst<G>.rules[R].expr>()), sv, out, n,
+            ctx...);
+    }
+
+    [[nodiscard]] CTPEG_CONSTEXPR Remaining
+    recognize(std::string_view sv, auto &...ctx) const noexcept {
+        return detail::recognize(
+            Nest(lowerGrammar<G, grammarAst<G>.rules[R].expr>()), sv, ctx...);
+    }
+};
+
+// Builds the parser for node I of the grammar out of the library's parsers
+template <FixedString G, std::size_t I>
+[[nodiscard]] CTPEG_CONSTEXPR auto lowerGrammar() noexcept {
+    constexpr auto &ast = grammarAst<G>;
+    constexpr auto node = ast.nodes[I];
+    constexpr auto children = []<std::size_t... C>(std::index_sequence<C...>) {
+        return std::index_sequence<grammarChild<G>(I, C)...>{};
+    }(std::make_index_sequence<node.count>{});
+    constexpr auto lowerAll = []<std::size_t... C>(
+                                  auto make, std::index_sequence<C...>) {
+        return make(lowerGrammar<G, C>()...);
+    };
+    if constexpr (node.op == GrammarOp::Choice) {
+        return lowerAll([](auto... p) { return Choice(p...); }, children);
+    } else if constexpr (node.op == GrammarOp::Sequence) {
+        return lowerAll([](auto... p) { return Sequence(p...); }, children);
+    } else if constexpr (node.op == GrammarOp::Empty) {
+        return Empty;
+    } else if constexpr (node.op == GrammarOp::And) {
+        return Not(Not(lowerGrammar<G, node.first>()));
+    } else if constexpr (node.op == GrammarOp::Not) {
+        return Not(lowerGrammar<G, node.first>());
+    } else if constexpr (node.op == GrammarOp::Maybe) {
+        return Maybe(lowerGrammar<G, node.first>());
+    } else if constexpr (node.op == GrammarOp::Many) {
+        return Many(lowerGrammar<G, node.first>());
+    } else if constexpr (node.op == GrammarOp::Many1) {
+        return Many1(lowerGrammar<G, node.first>());
+    } else if constexpr (node.op == GrammarOp::Literal) {
+        if constexpr (node.length == 0) {
+            return Empty;
+        } else if constexpr (node.length == 1) {
+            return Char(ast.text[node.begin]);
+        } else {
+            return String(
+                std::string_view(ast.text.data() + node.begin, node.length));
+        }
+    } else if constexpr (node.op == GrammarOp::Class) {
+        return CharClass(node.set);
+    } else if constexpr (node.op == GrammarOp::Any) {
+        return Char();
+    } else if constexpr (ast.rules[node.rule].recursive) {
+        return GrammarRuleRef<G, node.rule>{};
+    } else {
+        // Rules which are not recursive are inlined
+        return lowerGrammar<G, ast.rules[node.rule].expr>();
+    }
+}
+
+// The error of grammar G as a template argument
+template <FixedString G>
+[[nodiscard]] constexpr auto grammarError() noexcept {
+    constexpr auto error = grammarAst<G>.error;
+    char text[error.size() + 1]{};
+    std::copy(error.begin(), error.end(), text);
+    return FixedString<error.size() + 1>(text);
+}
+
+// Only instantiated for an invalid grammar. The compiler shows the arguments
+// along with the assertion, i.e. the error and its offset in the grammar.
+template <FixedString Error, std::size_t Offset>
+struct InvalidGrammar {
+    static_assert(Error.view().empty(),
+                  "ctpeg::grammar: the grammar is invalid, the error and its "
+                  "offset are the arguments of InvalidGrammar");
+};
+
+template <FixedString G>
+[[nodiscard]] CTPEG_CONSTEXPR auto lowerGrammar() noexcept {
+    if constexpr (grammarAst<G>.error.empty()) {
+        return lowerGrammar<G, grammarAst<G>.rules[0].expr>();
+    } else {
+        return InvalidGrammar<grammarError<G>(),
+                              grammarAst<G>.errorPosition>{};
+    }
+}
+
+}  // namespace v0_3_1
+}  // namespace ctpeg::detail
+
+namespace ctpeg {
+inline namespace v0_3_1 {
+
+// Parser for a grammar written in PEG notation, starting at its first rule:
+//   constexpr auto list = ctpeg::grammar<R"(
+//       List <- '[' Int (',' Int)* ']'
+//       Int  <- [0-9]+
+//   )">;
+// The grammar is read at compile time and turned into the library's parsers.
+// Rules which are not recursive are inlined, character classes become
+// CharClass table lookups. Left recursion is rejected. Pass a DepthLimit
+// to bound how deeply recursive rules may nest on untrusted input.
+template <detail::FixedString G>
+inline CTPEG_CONSTEXPR auto grammar = detail::lowerGrammar<G>();
+
 }  // namespace v0_3_1
 }  // namespace ctpeg
 #endif  // CTPEG_HPP
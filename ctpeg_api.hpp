@@ -0,0 +1,85 @@
+#ifndef CTPEG_API_HPP
+#define CTPEG_API_HPP
+#include <optional>
+#include <string_view>
+#include <utility>
+
+/*
+ * Thin interface to a grammar compiled in a single translation unit.
+ *
+ * Headers included by many translation units should only include this file and
+ * declare the parser with CTPEG_DECLARE_PARSER. The grammar itself lives in one
+ * .cpp file, which includes ctpeg.hpp and uses CTPEG_DEFINE_PARSER. That way
+ * only that file instantiates the parsers (and includes tl/expected.hpp and
+ * <variant>), every other one just sees a function declaration.
+ *
+ *     // number.hpp
+ *     #include "ctpeg_api.hpp"
+ *     CTPEG_DECLARE_PARSER(parseNumber, int64_t);
+ *
+ *     // number.cpp
+ *     #include "ctpeg.hpp"
+ *     #include "number.hpp"
+ *     constexpr auto number = ctpeg::Final(ctpeg::Int());
+ *     static_assert(ctpeg::parseValue<int64_t>(number, "42").value() == 42);
+ *     CTPEG_DEFINE_PARSER(parseNumber, int64_t, number)
+ */
+
+namespace ctpeg::api {
+inline namespace v0_3_1 {
+
+// Reason a parse failed
+struct ParseError {
+    std::string_view message;
+};
+
+// Either the value produced by a parser or the reason it failed
+template <typename T>
+class ErrorOr {
+    std::optional<T> m_value;
+    std::string_view m_error;
+
+public:
+    constexpr ErrorOr(T value) noexcept
+        : m_value(std::move(value)), m_error() {}
+    constexpr ErrorOr(ParseError error) noexcept
+        : m_value(), m_error(error.message) {}
+
+    [[nodiscard]] constexpr bool has_value() const noexcept {
+        return m_value.has_value();
+    }
+    [[nodiscard]] constexpr explicit operator bool() const noexcept {
+        return has_value();
+    }
+
+    [[nodiscard]] constexpr const T &value() const & { return m_value.value(); }
+    [[nodiscard]] constexpr T &value() & { return m_value.value(); }
+    [[nodiscard]] constexpr const T &operator*() const & { return *m_value; }
+    [[nodiscard]] constexpr const T *operator->() const {
+        return &*m_value;
+    }
+
+    // Empty if the parse succeeded
+    [[nodiscard]] constexpr std::string_view error() const noexcept {
+        return m_error;
+    }
+};
+
+}  // namespace v0_3_1
+}  // namespace ctpeg::api
+
+// Declares `ctpeg::api::ErrorOr<T> name(std::string_view)`
+#define CTPEG_DECLARE_PARSER(name, T) \
+    ::ctpeg::api::ErrorOr<T> name(std::string_view input)
+
+// Defines the function declared with CTPEG_DECLARE_PARSER. Requires ctpeg.hpp.
+// The parser (the remaining arguments) is run through `ctpeg::parseValue`.
+// Input left over after it is ignored, wrap the parser in Final to reject it.
+#define CTPEG_DEFINE_PARSER(name, T, ...)                       \
+    ::ctpeg::api::ErrorOr<T> name(std::string_view input) {     \
+        auto ret = ::ctpeg::parseValue<T>(__VA_ARGS__, input);  \
+        if (!ret) return ::ctpeg::api::ParseError{ret.error()}; \
+        return std::move(ret).value();                          \
+    }
+
+#endif  // CTPEG_API_HPP
@@ -0,0 +1,8 @@
+#include "math_parser.hpp"
+
+int main(int argc, char **argv) {
+    const std::string_view inputExpr = argc > 1 ? argv[1] : "1337 - 259 * 5";
+    const auto res = parseExpression(inputExpr);
+    if (!res) return -1;
+    return static_cast<int>(res->run());
+}
@@ -0,0 +1,12 @@
+#include "math_parser.hpp"
+
+#include "../math_expr_parser.hpp"
+
+#ifndef CTPEG_NO_CONSTEXPR
+// The grammar can still be checked at compile time, here rather than in every
+// file which parses expressions
+static_assert(
+    ctpeg::parseValue<Expr>(parser, "1337 - 259 * 5").value().run() == 42);
+#endif
+
+CTPEG_DEFINE_PARSER(parseExpression, Expr, parser)
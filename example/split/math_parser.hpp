@@ -0,0 +1,10 @@
+#ifndef CTPEG_SPLIT_MATH_PARSER_HPP
+#define CTPEG_SPLIT_MATH_PARSER_HPP
+
+#include "../../ctpeg_api.hpp"
+#include "../math_expr.hpp"
+
+// Defined in math_parser.cpp, the only file which includes ctpeg.hpp
+CTPEG_DECLARE_PARSER(parseExpression, Expr);
+
+#endif  // CTPEG_SPLIT_MATH_PARSER_HPP
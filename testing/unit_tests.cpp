@@ -39,6 +39,344 @@ CTPEG_CONSTEXPR bool testFailure(std::string_view input, const Parser &parser) {
     return !parser(input);
 }
 
+template <typename Parser>
+CTPEG_CONSTEXPR bool testParse(std::string_view input, const Parser &parser,
+                               const ctpeg::ValueOf_t<Parser> &expectedValue,
+                               std::string_view expectedRemaining) {
+    ctpeg::ValueOf_t<Parser> value{};
+    const auto ret = parser.parse(input, value);
+    return ret && ret.value() == expectedRemaining && value == expectedValue;
+}
+
+template <typename Parser>
+CTPEG_CONSTEXPR bool testRecognize(std::string_view input, const Parser &parser,
+                                   std::size_t expectedLength) {
+    const auto ret = ctpeg::Recognize(parser)(input);
+    return ret && ret.value() == expectedLength;
+}
+
+template <typename Parser>
+CTPEG_CONSTEXPR bool testRecognizeFailure(std::string_view input,
+                                          const Parser &parser) {
+    return !ctpeg::Recognize(parser)(input);
+}
+
+CTPEG_CONSTEXPR bool testCapture() {
+    // list <- '[' item (',' item)* ']'
+    // item <- Int
+    constexpr std::size_t list = 0;
+    constexpr std::size_t item = 1;
+    const auto parser = ctpeg::Capture(
+        list, ctpeg::Sequence(
+                  ctpeg::Char('['), ctpeg::Capture(item, ctpeg::Int()),
+                  ctpeg::Skip(ctpeg::Many(ctpeg::Skip(ctpeg::Sequence(
+                      ctpeg::Char(','), ctpeg::Capture(item, ctpeg::Int()))))),
+                  ctpeg::Char(']')));
+    constexpr std::string_view input = "[1,22,333]";
+    ctpeg::NodeArena arena;
+    arena.reset(input);
+    if (!parser(input, arena)) return false;
+    if (arena.size() != 4) return false;
+    if (arena[0].rule != list || arena.text(arena[0]) != input) return false;
+
+    std::array<std::string_view, 3> expected{"1", "22", "333"};
+    std::size_t count = 0;
+    bool passed = true;
+    arena.forEachChild(0, [&](std::size_t, const ctpeg::Node &node) {
+        if (passed) passed = node.rule == item && count < expected.size() &&
+                             arena.text(node) == expected[count];
+        count++;
+    });
+    if (!passed || count != expected.size()) return false;
+
+    // The arena is reusable, and nothing is recorded without it
+    arena.reset(input);
+    return parser(input) && arena.empty();
+}
+
+CTPEG_CONSTEXPR bool testCaptureBacktracking() {
+    // Nodes recorded by an alternative which later failed must be discarded
+    const auto parser = ctpeg::Capture(
+        0, ctpeg::Choice(
+               ctpeg::Sequence(ctpeg::Capture(1, ctpeg::Char('a')),
+                               ctpeg::Char('x')),
+               ctpeg::Sequence(ctpeg::Char('a'),
+                               ctpeg::Not(ctpeg::Capture(3, ctpeg::Char('c'))),
+                               ctpeg::Capture(2, ctpeg::Char('b')))));
+    constexpr std::string_view input = "ab";
+    ctpeg::NodeArena arena;
+    arena.reset(input);
+    if (!parser(input, arena)) return false;
+    return arena.size() == 2 && arena[0].childrenEnd == 2 &&
+           arena[1].rule == 2 && arena[1].begin == 1 && arena[1].end == 2;
+}
+
+CTPEG_CONSTEXPR bool testRecover() {
+    // records <- (Int ';')*, with every bad record skipped up to its ';'
+    const auto record = ctpeg::Action(
+        ctpeg::Sequence(ctpeg::Int(), ctpeg::Skip(ctpeg::Char(';'))),
+        [](const ctpeg::ResultVariant &v) {
+            return std::get<int64_t>(std::get<ctpeg::ResultVariantArray>(v)[0]);
+        });
+    const auto parser = ctpeg::Many(ctpeg::Recover(record, ";"));
+    constexpr std::string_view input = "1;x;3;4y;5;";
+    ctpeg::ErrorLog errors;
+    const auto ret = parser(input, errors);
+    if (!ret || !ret.value().second.empty()) return false;
+    const auto arr = std::get<ctpeg::ResultVariantArray>(ret.value().first);
+    if (std::get<int64_t>(arr[0]) != 1 || std::get<int64_t>(arr[2]) != 3 ||
+        std::get<int64_t>(arr[4]) != 5)
+        return false;
+    if (std::get<ctpeg::RecoveredError>(arr[1]).skipped != "x;" ||
+        std::get<ctpeg::RecoveredError>(arr[3]).skipped != "4y;")
+        return false;
+    return errors.size() == 2 && errors[0].skipped == "x;" &&
+           errors[1].skipped == "4y;";
+}
+
+CTPEG_CONSTEXPR bool testRecoverBacktracking() {
+    // Errors recovered from inside an alternative which failed are discarded
+    const auto parser = ctpeg::Choice(
+        ctpeg::Sequence(ctpeg::Recover(ctpeg::Char('a'), ";"), ctpeg::Char('z')),
+        ctpeg::Char('b'));
+    ctpeg::ErrorLog errors;
+    return parser("b;", errors) && errors.empty();
+}
+
+// Int() which counts how many times it was run
+struct CountingInt {
+    int *calls;
+
+    CTPEG_CONSTEXPR ctpeg::Result operator()(std::string_view sv) const {
+        ++*calls;
+        return ctpeg::Int()(sv);
+    }
+
+    CTPEG_CONSTEXPR std::size_t reach(bool) const { return 1; }
+};
+
+CTPEG_CONSTEXPR bool testIncremental() {
+    // list <- (record ';')*
+    int calls = 0;
+    const auto record = ctpeg::Memo(
+        0, ctpeg::Capture(
+               1, ctpeg::Sequence(CountingInt{&calls}, ctpeg::Char(';'))));
+    ctpeg::Incremental doc(ctpeg::Many(ctpeg::Skip(record)));
+    ctpeg::NodeArena arena;
+
+    doc.assign("1;22;333;4444;");
+    arena.reset(doc.text());
+    if (!doc.parse(arena) || calls != 4 || arena.size() != 4) return false;
+
+    // Only the edited record is parsed again
+    doc.edit(2, 2, "5");
+    arena.reset(doc.text());
+    calls = 0;
+    if (!doc.parse(arena) || calls != 1 || arena.size() != 4) return false;
+    if (arena.text(arena[1]) != "5;" || arena.text(arena[3]) != "4444;" ||
+        arena[3].begin != 8)
+        return false;
+
+    // Appending to the end has to be seen by Many
+    doc.edit(doc.text().size(), 0, "6;");
+    arena.reset(doc.text());
+    calls = 0;
+    if (!doc.parse(arena) || calls != 1 || arena.size() != 5) return false;
+
+    // Breaking a record ends the list there
+    doc.edit(5, 1, "x");
+    arena.reset(doc.text());
+    calls = 0;
+    const auto ret = doc.parse(arena);
+    return ret && ret.value().second == "3x3;4444;6;" && calls == 1 &&
+           arena.size() == 2;
+}
+
+CTPEG_CONSTEXPR bool testIncrementalErrors() {
+    const auto record = ctpeg::Memo(
+        0, ctpeg::Skip(ctpeg::Recover(
+               ctpeg::Sequence(ctpeg::Int(), ctpeg::Char(';')), ";")));
+    ctpeg::Incremental doc(ctpeg::Many(record));
+    ctpeg::ErrorLog log;
+
+    doc.assign("1;x;3;");
+    if (!doc.parse(log) || log.size() != 1) return false;
+
+    // The broken record is reused, its error has to be reported again
+    doc.edit(0, 1, "7");
+    log.reset();
+    if (!doc.parse(log) || log.size() != 1) return false;
+    return log[0].skipped == "x;" &&
+           log[0].skipped.data() == doc.text().data() + 2;
+}
+
+// Sink which writes down every event it is sent
+struct EventLog {
+    struct Event {
+        char kind;
+        std::size_t rule;
+        std::size_t a;
+        std::size_t b;
+
+        constexpr bool operator==(const Event &) const = default;
+    };
+
+    std::vector<Event> events{};
+
+    CTPEG_CONSTEXPR void begin(std::size_t rule, std::size_t offset) {
+        events.push_back({'b', rule, offset, 0});
+    }
+
+    CTPEG_CONSTEXPR void value(std::size_t rule, int64_t value) {
+        events.push_back({'v', rule, static_cast<std::size_t>(value), 0});
+    }
+
+    CTPEG_CONSTEXPR void end(std::size_t rule, std::size_t begin,
+                             std::size_t end) {
+        events.push_back({'e', rule, begin, end});
+    }
+};
+
+CTPEG_CONSTEXPR bool testEvents() {
+    // list <- item (',' item)*
+    constexpr std::size_t list = 0;
+    constexpr std::size_t item = 1;
+    const auto parser =
+        ctpeg::Report(list, ctpeg::SepBy(ctpeg::Report(item, ctpeg::Int()),
+                                         ctpeg::Char(',')));
+    EventLog log;
+    const auto ret = ctpeg::parseEvents(parser, "1,22", log);
+    return ret && ret.value().empty() &&
+           log.events == std::vector<EventLog::Event>{{'b', list, 0, 0},
+                                                      {'b', item, 0, 0},
+                                                      {'v', item, 1, 0},
+                                                      {'e', item, 0, 1},
+                                                      {'b', item, 2, 0},
+                                                      {'v', item, 22, 0},
+                                                      {'e', item, 2, 4},
+                                                      {'e', list, 0, 4}};
+}
+
+CTPEG_CONSTEXPR bool testEventsBacktracking() {
+    // Events of an alternative which failed, or of a lookahead, are not sent
+    const auto parser = ctpeg::Sequence(
+        ctpeg::Not(ctpeg::Report(0, ctpeg::Char('a'))),
+        ctpeg::Choice(
+            ctpeg::Sequence(ctpeg::Report(1, ctpeg::Int()), ctpeg::Char('x')),
+            ctpeg::Report(2, ctpeg::Int())));
+    EventLog log;
+    const auto ret = ctpeg::parseEvents(parser, "12", log);
+    return ret && log.events == std::vector<EventLog::Event>{{'b', 2, 0, 0},
+                                                             {'v', 2, 12, 0},
+                                                             {'e', 2, 0, 2}};
+}
+
+CTPEG_CONSTEXPR bool testEventsMemo() {
+    // The second alternative reuses the result of the first one's Memo, it
+    // still has to send its events
+    const auto item = ctpeg::Memo(0, ctpeg::Report(1, ctpeg::Int()));
+    const auto parser =
+        ctpeg::Choice(ctpeg::Sequence(item, ctpeg::Char('x')), item);
+    const std::string_view input = "12";
+    ctpeg::MemoTable table;
+    table.reset(input);
+    EventLog log;
+    const auto ret = ctpeg::parseEvents(parser, input, log, table);
+    return ret && log.events == std::vector<EventLog::Event>{{'b', 1, 0, 0},
+                                                             {'v', 1, 12, 0},
+                                                             {'e', 1, 0, 2}};
+}
+
+CTPEG_CONSTEXPR bool testFoldLongList() {
+    // Far more elements than fit in CTPEG_MAX_SEQUENCE_LENGTH
+    std::string input = "1";
+    for (int i = 1; i < 10000; i++) input += ",1";
+    const auto sum = ctpeg::Fold(
+        ctpeg::SepBy(ctpeg::Int(), ctpeg::Char(',')), int64_t{0},
+        [](int64_t acc, int64_t value) { return acc + value; });
+    const auto ret = sum(input);
+    return ret && std::get<int64_t>(ret.value().first) == 10000 &&
+           ret.value().second.empty();
+}
+
+CTPEG_CONSTEXPR bool testTooLong() {
+    // A result which does not fit CTPEG_MAX_SEQUENCE_LENGTH is not hidden by
+    // the other alternatives of a Choice, or by Recover
+    const std::string as(CTPEG_MAX_SEQUENCE_LENGTH + 50, 'a');
+    const auto choice =
+        ctpeg::Choice(ctpeg::Many1(ctpeg::Char('a')), ctpeg::Char('a'))(as);
+    if (choice || choice.error() != ctpeg::detail::TooLong) return false;
+    const auto recover =
+        ctpeg::Recover(ctpeg::Many1(ctpeg::Char('a')), ";")(as);
+    if (recover || recover.error() != ctpeg::detail::TooLong) return false;
+
+    // 8 elements per level, so that it does not have to be nested too deeply
+    // for constant evaluation
+    const auto parens =
+        ctpeg::grammar<"P <- '(' '(' '(' '(' P ')' ')' ')' ')' / 'x'">;
+    const auto nested =
+        parens(std::string(52, '(') + "x" + std::string(52, ')'));
+    return !nested && nested.error() == ctpeg::detail::TooLong;
+}
+
+CTPEG_CONSTEXPR bool testDepthLimit() {
+    const auto parens = ctpeg::grammar<"P <- '(' P ')' / 'x'">;
+    ctpeg::DepthLimit limit(3);
+    if (!ctpeg::parseValue<ctpeg::ResultVariantArray>(parens, "((x))", limit)) {
+        return false;
+    }
+    if (limit.depth() != 0 || limit.exceeded()) return false;
+
+    // Far deeper than the limit fails cleanly
+    const std::string deep =
+        std::string(10000, '(') + "x" + std::string(10000, ')');
+    auto ret = ctpeg::parseValue<ctpeg::ResultVariantArray>(parens, deep, limit);
+    if (ret || ret.error() != ctpeg::TooDeep || !limit.exceeded()) return false;
+
+    // And keeps failing until it is reset
+    if (ctpeg::parseValue<char>(parens, "x", limit)) return false;
+    limit.reset();
+    return ctpeg::parseValue<char>(parens, "x", limit).value() == 'x';
+}
+
+CTPEG_CONSTEXPR bool testDepthLimitAlternatives() {
+    // The other alternative could match the input without nesting, it must not
+    // be tried once the limit has been hit
+    const auto parens = ctpeg::grammar<"P <- '(' P ')' / '('* 'x' ')'*">;
+    const std::string deep =
+        std::string(10, '(') + "x" + std::string(10, ')');
+    ctpeg::DepthLimit limit(3);
+    const auto ret = parens(deep, limit);
+    if (ret || ret.error() != ctpeg::TooDeep || !limit.exceeded()) return false;
+    limit.reset();
+    const auto recognized = ctpeg::Recognize(parens)(deep, limit);
+    if (recognized || recognized.error() != ctpeg::TooDeep) return false;
+
+    // Nor does a repetition, Recover or Not hide it
+    limit.reset();
+    const auto many = ctpeg::Many(parens)(deep, limit);
+    if (many || many.error() != ctpeg::TooDeep) return false;
+    limit.reset();
+    const auto recover = ctpeg::Recover(parens, ";")(deep, limit);
+    if (recover || recover.error() != ctpeg::TooDeep) return false;
+    limit.reset();
+    const auto lookahead = ctpeg::Not(parens)(deep, limit);
+    return !lookahead && lookahead.error() == ctpeg::TooDeep;
+}
+
+CTPEG_CONSTEXPR bool testRecognizeDepthLimit() {
+    const auto recognizer =
+        ctpeg::Recognize(ctpeg::grammar<"P <- '(' P ')' / 'x'">);
+    ctpeg::DepthLimit limit(3);
+    if (recognizer("((x))", limit).value() != 5) return false;
+    if (limit.depth() != 0) return false;
+
+    const std::string deep =
+        std::string(10000, '(') + "x" + std::string(10000, ')');
+    auto ret = recognizer(deep, limit);
+    return !ret && ret.error() == ctpeg::TooDeep && limit.exceeded();
+}
+
 int main() {
     using namespace std::literals;
     // Char()
@@ -100,6 +438,23 @@ int main() {
         testFailure("cde", ctpeg::Choice(ctpeg::Char('a'), ctpeg::Char('b'))));
     CTPEG_ASSERT(
         testFailure("", ctpeg::Choice(ctpeg::Char('a'), ctpeg::Char('b'))));
+    // Without alternatives nothing matches
+    CTPEG_ASSERT(testFailure("a", ctpeg::Choice()));
+    CTPEG_ASSERT(testFailure("", ctpeg::Choice()));
+    CTPEG_ASSERT(testRecognizeFailure("a", ctpeg::Choice()));
+    CTPEG_ASSERT(testTooLong());
+    // Nested choices are stored flat
+    CTPEG_ASSERT(testSuccess(
+        "cde",
+        ctpeg::Choice(ctpeg::Char('a'),
+                      ctpeg::Choice(ctpeg::Char('b'), ctpeg::Char('c'))),
+        'c', "de"));
+    static_assert(
+        std::same_as<decltype(ctpeg::Choice(
+                         ctpeg::Choice(ctpeg::Char(), ctpeg::Int()),
+                         ctpeg::Char())),
+                     ctpeg::ChoiceParser<ctpeg::Char, ctpeg::Int,
+                                         ctpeg::Char>>);
 
     // Not
     CTPEG_ASSERT(testSuccess("bcde", Not(ctpeg::Char('a')),
@@ -139,6 +494,18 @@ int main() {
         "cde", ctpeg::Sequence(ctpeg::Char('a'), ctpeg::Char('b'))));
     CTPEG_ASSERT(
         testFailure("", ctpeg::Sequence(ctpeg::Char('a'), ctpeg::Char('b'))));
+    // Nested sequences are stored flat
+    CTPEG_ASSERT(testSuccessArray(
+        "abcde",
+        ctpeg::Sequence(ctpeg::Sequence(ctpeg::Char('a'), ctpeg::Char('b')),
+                        ctpeg::Char('c')),
+        {'a', 'b', 'c'}, "de"));
+    static_assert(
+        std::same_as<decltype(ctpeg::Sequence(
+                         ctpeg::Char(),
+                         ctpeg::Sequence(ctpeg::Int(), ctpeg::Char()))),
+                     ctpeg::SequenceParser<ctpeg::Char, ctpeg::Int,
+                                           ctpeg::Char>>);
 
     // Many
     CTPEG_ASSERT(testSuccessArray("aaabcd", ctpeg::Many(ctpeg::Char('a')),
@@ -147,9 +514,414 @@ int main() {
         testSuccessArray("abcd", ctpeg::Many(ctpeg::Char('a')), {'a'}, "bcd"));
     CTPEG_ASSERT(testSuccessArray("bcd", ctpeg::Many(ctpeg::Char('a')),
                                   std::initializer_list<char>{}, "bcd"));
+    // An element which consumes nothing ends the repetition
+    CTPEG_ASSERT(testParse("bc", ctpeg::Many(ctpeg::Maybe(ctpeg::Char('a'))),
+                           ctpeg::ResultVariantArray{ctpeg::EmptyVariant{}},
+                           "bc"));
     CTPEG_ASSERT(testSuccessArray("", ctpeg::Many(ctpeg::Char('a')),
                                   std::initializer_list<char>{}, ""));
 
+    // Many1
+    CTPEG_ASSERT(testSuccessArray("aab", ctpeg::Many1(ctpeg::Char('a')),
+                                  {'a', 'a'}, "b"));
+    CTPEG_ASSERT(testFailure("b", ctpeg::Many1(ctpeg::Char('a'))));
+    CTPEG_ASSERT(testRecognizeFailure("b", ctpeg::Many1(ctpeg::Char('a'))));
+
+    // Repeat
+    CTPEG_ASSERT(testSuccessArray("aaaa", ctpeg::Repeat<2, 3>(ctpeg::Char('a')),
+                                  {'a', 'a', 'a'}, "a"));
+    CTPEG_ASSERT(testSuccessArray("aab", ctpeg::Repeat<2, 3>(ctpeg::Char('a')),
+                                  {'a', 'a'}, "b"));
+    CTPEG_ASSERT(testFailure("ab", ctpeg::Repeat<2, 3>(ctpeg::Char('a'))));
+    CTPEG_ASSERT(testSuccessArray("aaa", ctpeg::Repeat<2>(ctpeg::Char('a')),
+                                  {'a', 'a'}, "a"));
+    CTPEG_ASSERT(
+        testRecognize("aaaa", ctpeg::Repeat<2, 3>(ctpeg::Char('a')), 3));
+
+    // SepBy
+    CTPEG_ASSERT(testSuccessArray(
+        "1,22,3;", ctpeg::SepBy(ctpeg::Int(), ctpeg::Char(',')),
+        {int64_t{1}, int64_t{22}, int64_t{3}}, ";"));
+    // A trailing separator is left alone
+    CTPEG_ASSERT(testSuccessArray("1,2,",
+                                  ctpeg::SepBy(ctpeg::Int(), ctpeg::Char(',')),
+                                  {int64_t{1}, int64_t{2}}, ","));
+    CTPEG_ASSERT(testSuccessArray(
+        ";", ctpeg::SepBy(ctpeg::Int(), ctpeg::Char(',')),
+        std::initializer_list<int64_t>{}, ";"));
+    CTPEG_ASSERT(
+        testRecognize("1,2,", ctpeg::SepBy(ctpeg::Int(), ctpeg::Char(',')), 3));
+
+    // Fold
+    CTPEG_ASSERT(testSuccess(
+        "1,2,3;",
+        ctpeg::Fold(ctpeg::SepBy(ctpeg::Int(), ctpeg::Char(',')), int64_t{0},
+                    [](int64_t acc, int64_t value) { return acc + value; }),
+        int64_t{6}, ";"));
+    // Other parsers are repeated like Many
+    CTPEG_ASSERT(testSuccess(
+        "aab",
+        ctpeg::Fold(ctpeg::Char('a'), int64_t{0},
+                    [](int64_t acc, char) { return acc + 1; }),
+        int64_t{2}, "b"));
+    CTPEG_ASSERT(testFailure(
+        "b", ctpeg::Fold(ctpeg::Many1(ctpeg::Char('a')), int64_t{0},
+                         [](int64_t acc, char) { return acc + 1; })));
+    CTPEG_ASSERT(testFoldLongList());
+
+    // Action
+    CTPEG_ASSERT(testSuccess(
+        "7ab",
+        ctpeg::Action(ctpeg::Digit(),
+                      [](const ctpeg::ResultVariant &v) {
+                          return std::get<int64_t>(v) * 2;
+                      }),
+        std::int64_t(14), "ab"));
+    CTPEG_ASSERT(testFailure(
+        "ab", ctpeg::Action(ctpeg::Digit(), [](const ctpeg::ResultVariant &v) {
+            return v;
+        })));
+
+    // Recognize
+    CTPEG_ASSERT(testRecognize("abc", ctpeg::Char(), 1));
+    CTPEG_ASSERT(testRecognizeFailure("abc", ctpeg::Char('b')));
+    CTPEG_ASSERT(testRecognize("1ab", ctpeg::Digit(1), 1));
+    CTPEG_ASSERT(testRecognizeFailure("2ab", ctpeg::Digit(1)));
+    CTPEG_ASSERT(testRecognize("abcdef", ctpeg::String("abc"), 3));
+    CTPEG_ASSERT(testRecognizeFailure("ab", ctpeg::String("abc")));
+    CTPEG_ASSERT(testRecognize("123abc", ctpeg::Int(), 3));
+    CTPEG_ASSERT(testRecognize("12ab", ctpeg::Int(12), 2));
+    CTPEG_ASSERT(testRecognizeFailure("13ab", ctpeg::Int(12)));
+    CTPEG_ASSERT(testRecognize("bcde",
+                               ctpeg::Choice(ctpeg::Char('a'), ctpeg::Char('b')),
+                               1));
+    CTPEG_ASSERT(testRecognizeFailure(
+        "cde", ctpeg::Choice(ctpeg::Char('a'), ctpeg::Char('b'))));
+    CTPEG_ASSERT(testRecognize(
+        "a1 b", ctpeg::Sequence(ctpeg::Char('a'), ctpeg::Int(), ctpeg::Char(' ')),
+        3));
+    CTPEG_ASSERT(testRecognizeFailure(
+        "a b", ctpeg::Sequence(ctpeg::Char('a'), ctpeg::Int())));
+    CTPEG_ASSERT(testRecognize("aaabcd", ctpeg::Many(ctpeg::Char('a')), 3));
+    CTPEG_ASSERT(testRecognize("", ctpeg::Many(ctpeg::Char('a')), 0));
+    CTPEG_ASSERT(testRecognize("bc", ctpeg::Many(ctpeg::Maybe(ctpeg::Char('a'))),
+                               0));
+    CTPEG_ASSERT(testRecognize("bcde", ctpeg::Not(ctpeg::Char('a')), 0));
+    CTPEG_ASSERT(testRecognizeFailure("abcde", ctpeg::Not(ctpeg::Char('a'))));
+    CTPEG_ASSERT(testRecognize("abcde", ctpeg::Skip(ctpeg::Char('a')), 1));
+    CTPEG_ASSERT(testRecognize("a", ctpeg::Final(ctpeg::Char('a')), 1));
+    CTPEG_ASSERT(testRecognizeFailure("ab", ctpeg::Final(ctpeg::Char('a'))));
+    // Actions are not run, user functions are
+    CTPEG_ASSERT(testRecognize(
+        "7ab",
+        ctpeg::Action(ctpeg::Digit(),
+                      [](const ctpeg::ResultVariant &) -> int64_t {
+                          std::terminate();
+                      }),
+        1));
+    CTPEG_ASSERT(testRecognize(
+        "7ab",
+        +[](std::string_view sv) -> ctpeg::Result { return ctpeg::Digit()(sv); },
+        1));
+
+    // Recover
+    CTPEG_ASSERT(testSuccess("abc", ctpeg::Recover(ctpeg::Char('a'), ";"), 'a',
+                             "bc"));
+    CTPEG_ASSERT(testSuccess("xy;z", ctpeg::Recover(ctpeg::Char('a'), ";"),
+                             ctpeg::RecoveredError{"Failed to parse Char", "xy;"},
+                             "z"));
+    CTPEG_ASSERT(testSuccess("xyz", ctpeg::Recover(ctpeg::Char('a'), ";"),
+                             ctpeg::RecoveredError{"Failed to parse Char", "xyz"},
+                             ""));
+    CTPEG_ASSERT(testFailure("", ctpeg::Recover(ctpeg::Char('a'), ";")));
+    CTPEG_ASSERT(
+        testRecognize("xy;z", ctpeg::Recover(ctpeg::Char('a'), ";\n"), 3));
+    CTPEG_ASSERT(testRecover());
+    CTPEG_ASSERT(testRecoverBacktracking());
+
+    // Memo
+    CTPEG_ASSERT(testSuccess("abc", ctpeg::Memo(0, ctpeg::Char('a')), 'a', "bc"));
+    CTPEG_ASSERT(testIncremental());
+    CTPEG_ASSERT(testIncrementalErrors());
+
+    // Nested arrays are spliced into Sequence and Many
+    CTPEG_ASSERT(testSuccessArray(
+        "abbc",
+        ctpeg::Sequence(ctpeg::Char('a'), ctpeg::Many(ctpeg::Char('b')),
+                        ctpeg::Char('c')),
+        {'a', 'b', 'b', 'c'}, ""));
+    CTPEG_ASSERT(testSuccessArray(
+        "abab",
+        ctpeg::Final(ctpeg::Many(
+            ctpeg::Sequence(ctpeg::Char('a'), ctpeg::Char('b')))),
+        {'a', 'b', 'a', 'b'}, ""));
+
+    // parse
+    CTPEG_ASSERT(testParse("abc", ctpeg::Char('a'), 'a', "bc"));
+    CTPEG_ASSERT(testParse("12a", ctpeg::Int(), 12, "a"));
+    CTPEG_ASSERT(testParse("abc", ctpeg::String("ab"), "ab", "c"));
+    CTPEG_ASSERT(
+        testParse("b", ctpeg::Choice(ctpeg::Char('a'), ctpeg::Char('b')), 'b',
+                  ""));
+    CTPEG_ASSERT(testParse("1", ctpeg::Choice(ctpeg::Char('a'), ctpeg::Int()),
+                           ctpeg::ResultVariantSingle{int64_t{1}}, ""));
+    CTPEG_ASSERT(testParse(
+        "abc",
+        ctpeg::Sequence(ctpeg::Char('a'),
+                        ctpeg::Sequence(ctpeg::Char('b'), ctpeg::Char('c'))),
+        ctpeg::ResultVariantArray{'a', 'b', 'c'}, ""));
+    // Values of a failed alternative are not left behind
+    CTPEG_ASSERT(testParse(
+        "abd",
+        ctpeg::Many(ctpeg::Choice(
+            ctpeg::Sequence(ctpeg::Char('a'), ctpeg::Char('b'),
+                            ctpeg::Char('c')),
+            ctpeg::Sequence(ctpeg::Char('a'), ctpeg::Char('b')))),
+        ctpeg::ResultVariantArray{'a', 'b'}, "d"));
+    CTPEG_ASSERT(testParse("a", ctpeg::Final(ctpeg::Char('a')), 'a', ""));
+    CTPEG_ASSERT([] {
+        char c{};
+        return !ctpeg::Char('a').parse("b", c);
+    }());
+    static_assert(
+        std::same_as<ctpeg::ValueOf_t<decltype(ctpeg::Choice(
+                         ctpeg::Char(), ctpeg::CharClass("a")))>,
+                     char>);
+    static_assert(
+        std::same_as<ctpeg::ValueOf_t<decltype(ctpeg::Maybe(ctpeg::Char()))>,
+                     ctpeg::ResultVariantSingle>);
+    static_assert(std::same_as<ctpeg::ValueOf_t<ctpeg::Result (*)(
+                                   std::string_view)>,
+                               ctpeg::ResultVariant>);
+
+    // parseValue
+    CTPEG_ASSERT(ctpeg::parseValue<int64_t>(ctpeg::Int(), "12a").value() == 12);
+    CTPEG_ASSERT(
+        ctpeg::parseValue<char>(
+            ctpeg::Choice(ctpeg::Char('a'), ctpeg::Int()), "a")
+            .value() == 'a');
+    CTPEG_ASSERT(!ctpeg::parseValue<char>(
+        ctpeg::Choice(ctpeg::Char('a'), ctpeg::Int()), "1"));
+    CTPEG_ASSERT(!ctpeg::parseValue<int64_t>(ctpeg::Final(ctpeg::Int()), "1a"));
+
+    // CharClass
+    CTPEG_ASSERT(testSuccess("q1", ctpeg::CharClass("a-z_"), 'q', "1"));
+    CTPEG_ASSERT(testSuccess("_1", ctpeg::CharClass("a-z_"), '_', "1"));
+    CTPEG_ASSERT(testSuccess("-1", ctpeg::CharClass("a-"), '-', "1"));
+    CTPEG_ASSERT(testFailure("1", ctpeg::CharClass("a-z_")));
+    CTPEG_ASSERT(testFailure("", ctpeg::CharClass("a-z_")));
+    CTPEG_ASSERT(testRecognize("xy", ctpeg::CharClass("x"), 1));
+
+    // FixedInt
+    CTPEG_ASSERT(
+        testSuccess("\x12\x34z", ctpeg::U16BE(), int64_t{0x1234}, "z"));
+    CTPEG_ASSERT(
+        testSuccess("\x12\x34z", ctpeg::U16LE(), int64_t{0x3412}, "z"));
+    CTPEG_ASSERT(testSuccess("\xff\xfe", ctpeg::I16BE(), int64_t{-2}, ""));
+    CTPEG_ASSERT(testSuccess("\x80", ctpeg::U8(), int64_t{0x80}, ""));
+    CTPEG_ASSERT(testSuccess("\x80", ctpeg::I8(), int64_t{-128}, ""));
+    CTPEG_ASSERT(testSuccess("\x01\x02\x03\x04\x05\x06\x07\x08",
+                             ctpeg::U64LE(), int64_t{0x0807060504030201}, ""));
+    CTPEG_ASSERT(testSuccess("\xca\xfe\xba\xbe", ctpeg::U32BE(0xcafebabe),
+                             int64_t{0xcafebabe}, ""));
+    CTPEG_ASSERT(testFailure("\xca\xfe\xba\xbf", ctpeg::U32BE(0xcafebabe)));
+    CTPEG_ASSERT(testFailure("\x12", ctpeg::U16BE()));
+    CTPEG_ASSERT(testRecognize("\x12\x34\x56", ctpeg::U16LE(), 2));
+
+    // Bytes
+    CTPEG_ASSERT(testSuccess("abcd", ctpeg::Bytes<3>(), "abc"sv, "d"));
+    CTPEG_ASSERT(testSuccess("\0\0"sv, ctpeg::Bytes<2>(), "\0\0"sv, ""));
+    CTPEG_ASSERT(testFailure("ab", ctpeg::Bytes<3>()));
+
+    // LengthPrefixed
+    CTPEG_ASSERT(testSuccess("\x03"
+                             "abcd",
+                             ctpeg::LengthPrefixed<ctpeg::U8>(), "abc"sv, "d"));
+    CTPEG_ASSERT(testSuccess("\0\x02hi!"sv,
+                             ctpeg::LengthPrefixed<ctpeg::U16BE>(), "hi"sv,
+                             "!"));
+    CTPEG_ASSERT(testSuccess("\0"sv, ctpeg::LengthPrefixed<ctpeg::U8>(), ""sv,
+                             ""));
+    CTPEG_ASSERT(testFailure("\x05hi", ctpeg::LengthPrefixed<ctpeg::U8>()));
+    CTPEG_ASSERT(testFailure("\x02", ctpeg::LengthPrefixed<ctpeg::U16BE>()));
+    // The value points into the input
+    CTPEG_ASSERT([] {
+        const std::string_view input = "\x02hi";
+        std::string_view out{};
+        return ctpeg::LengthPrefixed<ctpeg::U8>().parse(input, out) &&
+               out.data() == input.data() + 1;
+    }());
+    // Binary fields mix with text
+    CTPEG_ASSERT(testParse(
+        "PK\x02\0\x02hi;"sv,
+        ctpeg::Sequence(ctpeg::String("PK"), ctpeg::U16LE(),
+                        ctpeg::LengthPrefixed<ctpeg::U8>(), ctpeg::Char(';')),
+        ctpeg::ResultVariantArray{"PK"sv, int64_t{2}, "hi"sv, ';'}, ""));
+
+    // LongestMatch
+    CTPEG_ASSERT(testSuccess(
+        "abc1 x", ctpeg::LongestMatch([] {
+            return ctpeg::Sequence(ctpeg::CharClass("a-zA-Z_"),
+                                   ctpeg::Many(ctpeg::CharClass("a-z0-9")));
+        }),
+        "abc1"sv, " x"));
+    CTPEG_ASSERT(testFailure("1abc", ctpeg::LongestMatch([] {
+        return ctpeg::Sequence(ctpeg::CharClass("a-zA-Z_"),
+                               ctpeg::Many(ctpeg::CharClass("a-z0-9")));
+    })));
+    CTPEG_ASSERT(testSuccess(
+        "-12.5e", ctpeg::LongestMatch([] {
+            return ctpeg::Sequence(
+                ctpeg::Maybe(ctpeg::Char('-')), ctpeg::Many1(ctpeg::Digit()),
+                ctpeg::Maybe(ctpeg::Sequence(ctpeg::Char('.'),
+                                             ctpeg::Many1(ctpeg::Digit()))));
+        }),
+        "-12.5"sv, "e"));
+    CTPEG_ASSERT(testSuccess(
+        "12.e", ctpeg::LongestMatch([] {
+            return ctpeg::Sequence(
+                ctpeg::Many1(ctpeg::Digit()),
+                ctpeg::Maybe(ctpeg::Sequence(ctpeg::Char('.'),
+                                             ctpeg::Many1(ctpeg::Digit()))));
+        }),
+        "12"sv, ".e"));
+    CTPEG_ASSERT(testSuccess("1,2,3,", ctpeg::LongestMatch([] {
+                                 return ctpeg::SepBy(ctpeg::Digit(),
+                                                     ctpeg::Char(','));
+                             }),
+                             "1,2,3"sv, ","));
+    CTPEG_ASSERT(testSuccess("aaaa", ctpeg::LongestMatch([] {
+                                 return ctpeg::Repeat<2, 3>(ctpeg::Char('a'));
+                             }),
+                             "aaa"sv, "a"));
+    CTPEG_ASSERT(testFailure("a", ctpeg::LongestMatch([] {
+                                 return ctpeg::Repeat<2, 3>(ctpeg::Char('a'));
+                             })));
+    CTPEG_ASSERT(testSuccess("\x7f" "ELF\x02", ctpeg::LongestMatch([] {
+                                 return ctpeg::Sequence(
+                                     ctpeg::U32BE(0x7f454c46),
+                                     ctpeg::Bytes<1>());
+                             }),
+                             "\x7f" "ELF\x02"sv, ""));
+    CTPEG_ASSERT(testSuccess(
+        "", ctpeg::LongestMatch([] { return ctpeg::Many(ctpeg::Char()); }),
+        ""sv, ""));
+    // Unlike the Choice on its own, which takes the first alternative
+    CTPEG_ASSERT(testSuccess(
+        "int x",
+        ctpeg::Choice(ctpeg::String("in"), ctpeg::String("int"),
+                      ctpeg::String("if")),
+        "in"sv, "t x"));
+    CTPEG_ASSERT(testSuccess("int x", ctpeg::LongestMatch([] {
+                                 return ctpeg::Choice(ctpeg::String("in"),
+                                                      ctpeg::String("int"),
+                                                      ctpeg::String("if"));
+                             }),
+                             "int"sv, " x"));
+    // And the repetition gives back what the rest of the sequence needs
+    CTPEG_ASSERT(testFailure(
+        "aa",
+        ctpeg::Sequence(ctpeg::Many(ctpeg::Char('a')), ctpeg::Char('a'))));
+    CTPEG_ASSERT(testSuccess("aa", ctpeg::LongestMatch([] {
+                                 return ctpeg::Sequence(
+                                     ctpeg::Many(ctpeg::Char('a')),
+                                     ctpeg::Char('a'));
+                             }),
+                             "aa"sv, ""));
+    // Grammar strings without recursion or lookahead are regular too
+    CTPEG_ASSERT(testSuccess("x_1+", ctpeg::LongestMatch([] {
+                                 return ctpeg::grammar<
+                                     "Id <- [a-z_] [a-z0-9_]*">;
+                             }),
+                             "x_1"sv, "+"));
+    CTPEG_ASSERT([] {
+        const auto keyword = ctpeg::LongestMatch([] {
+            return ctpeg::Choice(ctpeg::String("if"), ctpeg::String("int"),
+                                 ctpeg::String("in"));
+        });
+        // dead, start, "i", "in" and the other two merged
+        return decltype(keyword)::s_dfa.size == 5 &&
+               keyword.reach(true) == 1 && keyword.reach(false) == 2;
+    }());
+    // The DFA is shared, not copied into every parser which contains it
+    static_assert(sizeof(ctpeg::LongestMatch(
+                      [] { return ctpeg::String("int"); })) == 1);
+    static_assert(sizeof(ctpeg::Sequence(
+                      ctpeg::LongestMatch([] { return ctpeg::String("in"); }),
+                      ctpeg::Char(' '))) < 64);
+    static_assert(
+        !ctpeg::detail::IsRegular_v<decltype(ctpeg::Not(ctpeg::Char()))>);
+    static_assert(!ctpeg::detail::IsRegular_v<
+                  decltype(ctpeg::grammar<"P <- '(' P ')' / 'x'">)>);
+
+    // grammar
+    CTPEG_ASSERT(testSuccessArray(
+        "[1, 22]", ctpeg::grammar<R"(
+            # A list of numbers
+            List <- '[' _ Int (_ ',' _ Int)* _ ']'
+            Int  <- [0-9]+
+            _    <- [ \t]*
+        )">,
+        {'[', '1', ',', ' ', '2', '2', ']'}, ""));
+    CTPEG_ASSERT(testSuccessArray("((x))",
+                                  ctpeg::grammar<"P <- '(' P ')' / 'x'">,
+                                  {'(', '(', 'x', ')', ')'}, ""));
+    CTPEG_ASSERT(testSuccess("x", ctpeg::grammar<"P <- '(' P ')' / 'x'">, 'x',
+                             ""));
+    CTPEG_ASSERT(testFailure(
+        "((x)", ctpeg::Final(ctpeg::grammar<"P <- '(' P ')' / 'x'">)));
+    CTPEG_ASSERT(
+        testRecognize("((x))", ctpeg::grammar<"P <- '(' P ')' / 'x'">, 5));
+    CTPEG_ASSERT(testSuccess("abc", ctpeg::grammar<"S <- 'abc' / 'ab'">,
+                             "abc"sv, ""));
+    CTPEG_ASSERT(testSuccess("\n]", ctpeg::grammar<R"(S <- [^a-z\]])">, '\n',
+                             "]"));
+    CTPEG_ASSERT(testSuccessArray(
+        "'x", ctpeg::grammar<R"(S <- "'" . / 'y')">, {'\'', 'x'}, ""));
+    CTPEG_ASSERT(
+        testRecognize("ab", ctpeg::grammar<"S <- &'a' . !'a' 'b'?">, 2));
+    CTPEG_ASSERT(testRecognize("ba", ctpeg::grammar<"S <- () 'b'">, 1));
+    CTPEG_ASSERT(testRecognizeFailure("b", ctpeg::grammar<"S <- &'a' .">));
+    static_assert(
+        std::same_as<std::remove_cvref_t<decltype(ctpeg::grammar<"S <- 'a'+">)>,
+                     decltype(ctpeg::Many1(ctpeg::Char('a')))>);
+    static_assert(ctpeg::detail::grammarAst<"S <- T">.error ==
+                  "Reference to an undefined rule");
+    static_assert(ctpeg::detail::grammarAst<"S <- 'a">.error ==
+                  "Unterminated literal");
+    static_assert(ctpeg::detail::grammarAst<"S 'a'">.error ==
+                  "Expected '<-' after the rule name");
+    static_assert(ctpeg::detail::grammarAst<"S <- 'a' S <- 'b'">.error ==
+                  "Rule is defined more than once");
+    static_assert(
+        ctpeg::detail::grammarAst<"S <- 'a' S <- 'b'">.errorPosition == 9);
+    static_assert(ctpeg::detail::grammarAst<"E <- E '+' 'x' / 'x'">.error ==
+                  "Rule is left recursive");
+    static_assert(ctpeg::detail::grammarAst<R"(
+        A <- 'x'? B / 'y'
+        B <- A
+    )">.error == "Rule is left recursive");
+    static_assert(ctpeg::detail::grammarAst<"E <- 'x' E / 'x'">.error.empty());
+
+    // Nest
+    CTPEG_ASSERT(testDepthLimit());
+    CTPEG_ASSERT(testDepthLimitAlternatives());
+    CTPEG_ASSERT(testRecognizeDepthLimit());
+    CTPEG_ASSERT(testSuccess("a", ctpeg::Nest(ctpeg::Char('a')), 'a', ""));
+
+    // Report
+    CTPEG_ASSERT(
+        testSuccess("12", ctpeg::Report(0, ctpeg::Int()), int64_t{12}, ""));
+    CTPEG_ASSERT(testEvents());
+    CTPEG_ASSERT(testEventsBacktracking());
+    CTPEG_ASSERT(testEventsMemo());
+
+    // Capture
+    CTPEG_ASSERT(testCapture());
+    CTPEG_ASSERT(testCaptureBacktracking());
+    CTPEG_ASSERT(testSuccess("abc", ctpeg::Capture(0, ctpeg::Char('a')), 'a',
+                             "bc"));
+
     static_assert(ctpeg::Parser<ctpeg::Char>);
     static_assert(ctpeg::Parser<ctpeg::Digit>);
     static_assert(ctpeg::Parser<ctpeg::String>);
@@ -162,4 +934,28 @@ int main() {
     static_assert(ctpeg::Parser<decltype(ctpeg::Final(ctpeg::Char()))>);
     static_assert(ctpeg::Parser<decltype(ctpeg::Sequence(ctpeg::Char()))>);
     static_assert(ctpeg::Parser<decltype(ctpeg::Many(ctpeg::Char()))>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::Many1(ctpeg::Char()))>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::Repeat<1, 2>(ctpeg::Char()))>);
+    static_assert(
+        ctpeg::Parser<decltype(ctpeg::SepBy(ctpeg::Char(), ctpeg::Char()))>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::Fold(
+                      ctpeg::Int(), int64_t{0},
+                      [](int64_t acc, int64_t) { return acc; }))>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::Capture(0, ctpeg::Char()))>);
+    static_assert(
+        ctpeg::Parser<decltype(ctpeg::Recover(ctpeg::Char(), ";"))>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::Memo(0, ctpeg::Char()))>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::Report(0, ctpeg::Char()))>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::Nest(ctpeg::Char()))>);
+    static_assert(ctpeg::Parser<ctpeg::CharClass>);
+    static_assert(ctpeg::Parser<ctpeg::U32BE>);
+    static_assert(ctpeg::Parser<ctpeg::Bytes<4>>);
+    static_assert(ctpeg::Parser<ctpeg::LengthPrefixed<ctpeg::U16BE>>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::LongestMatch(
+                      [] { return ctpeg::Char(); }))>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::grammar<"S <- 'a' S / 'b'">)>);
+    static_assert(ctpeg::Parser<decltype(ctpeg::Action(
+                      ctpeg::Char(), [](const ctpeg::ResultVariant &v) {
+                          return v;
+                      }))>);
 }